@@ -0,0 +1,397 @@
+/*
+ * Copyright (c) 2026 FreeBSD Foundation
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDBusConnection>
+#include <QDBusConnectionInterface>
+#include <QDBusMessage>
+#include <QDBusMetaType>
+#include <QDBusReply>
+#include <QDeadlineTimer>
+#include <QFile>
+#include <QHash>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QTemporaryDir>
+#include <QThread>
+
+// Runs hostnamed on a private bus and measures it from the client side:
+// every client has its own connection and keeps exactly one call in flight.
+// Results go to stdout (or --output) as JSON, progress and errors to stderr.
+
+static const QString Hostname1Service = QStringLiteral("org.freedesktop.hostname1");
+static const QString Hostname1Interface = QStringLiteral("org.freedesktop.hostname1");
+static const QString Hostname1ObjectPath = QStringLiteral("/org/freedesktop/hostname1");
+static const QString PolkitService = QStringLiteral("org.freedesktop.PolicyKit1");
+static const QString PropertiesInterface = QStringLiteral("org.freedesktop.DBus.Properties");
+
+static const QStringList DefaultOperations = {
+    QStringLiteral("Get"),
+    QStringLiteral("GetAll"),
+    QStringLiteral("Describe"),
+    QStringLiteral("GetHardwareSerial"),
+};
+
+// They rewrite /etc/machine-info, so they only run when asked for
+static const QStringList SetterOperations = {
+    QStringLiteral("SetPrettyHostname"),
+    QStringLiteral("SetLocation"),
+    QStringLiteral("SetMachineInfo"),
+};
+
+// What the setters touch, saved before the run and put back afterwards
+static const QStringList SetterProperties = {
+    QStringLiteral("PrettyHostname"),
+    QStringLiteral("Location"),
+};
+
+static constexpr std::chrono::seconds StartupTimeout{10};
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+struct Samples
+{
+    // microseconds
+    QList<double> latencies;
+    qsizetype errors = 0;
+};
+
+using Results = QHash<QString, Samples>;
+
+QDBusMessage MakeCall(const QString& operation, quint64 iteration)
+{
+    // alternate between two values so that setters never hit the
+    // "unchanged" shortcut
+    const QString value = (iteration % 2) ? QStringLiteral("bench-a") : QStringLiteral("bench-b");
+
+    auto call = [](const QString& interface, const QString& method) {
+        return QDBusMessage::createMethodCall(Hostname1Service, Hostname1ObjectPath, interface, method);
+    };
+
+    if (operation == QLatin1String("Get"))
+        return call(PropertiesInterface, QStringLiteral("Get")) << Hostname1Interface << QStringLiteral("Hostname");
+    if (operation == QLatin1String("GetAll"))
+        return call(PropertiesInterface, QStringLiteral("GetAll")) << Hostname1Interface;
+    if (operation == QLatin1String("SetMachineInfo")) {
+        QMap<QString, QString> fields = {
+            {QStringLiteral("PrettyHostname"), value},
+            {QStringLiteral("Location"), value},
+        };
+        return call(Hostname1Interface, operation) << QVariant::fromValue(fields) << false;
+    }
+    if (operation.startsWith(QLatin1String("Set")))
+        return call(Hostname1Interface, operation) << value << false;
+    return call(Hostname1Interface, operation);
+}
+
+Results RunClient(const QString& address, int index, const QStringList& operations, QDeadlineTimer deadline)
+{
+    Results results;
+    const QString name = QStringLiteral("hostnamed-bench-%1").arg(index);
+
+    {
+        auto bus = QDBusConnection::connectToBus(address, name);
+        if (!bus.isConnected()) {
+            results[QStringLiteral("connect")].errors++;
+            return results;
+        }
+
+        // clients start at different operations, so the mix is even at any
+        // point in time
+        for (quint64 i = index; !deadline.hasExpired(); i++) {
+            const auto& operation = operations[i % operations.size()];
+            auto call = MakeCall(operation, i);
+
+            auto start = Clock::now();
+            auto reply = bus.call(call);
+            std::chrono::duration<double, std::micro> latency = Clock::now() - start;
+
+            auto& samples = results[operation];
+            if (reply.type() == QDBusMessage::ErrorMessage)
+                samples.errors++;
+            else
+                samples.latencies << latency.count();
+        }
+    }
+
+    QDBusConnection::disconnectFromBus(name);
+    return results;
+}
+
+double Percentile(const QList<double>& sorted, double p)
+{
+    if (sorted.isEmpty())
+        return 0;
+    qsizetype rank = qsizetype(std::ceil(p * sorted.size()));
+    return sorted[std::clamp<qsizetype>(rank - 1, 0, sorted.size() - 1)];
+}
+
+QJsonObject Summarize(Samples samples, double seconds)
+{
+    std::sort(samples.latencies.begin(), samples.latencies.end());
+
+    return {
+        {QStringLiteral("calls"), samples.latencies.size()},
+        {QStringLiteral("errors"), samples.errors},
+        {QStringLiteral("throughput"), samples.latencies.size() / seconds},
+        {QStringLiteral("p50_us"), Percentile(samples.latencies, 0.50)},
+        {QStringLiteral("p99_us"), Percentile(samples.latencies, 0.99)},
+        {QStringLiteral("p999_us"), Percentile(samples.latencies, 0.999)},
+    };
+}
+
+QMap<QString, QString> SaveSetterProperties(const QString& address)
+{
+    QMap<QString, QString> values;
+
+    auto bus = QDBusConnection::connectToBus(address, QStringLiteral("hostnamed-bench-setup"));
+    for (const auto& name : SetterProperties) {
+        auto call = MakeCall(QStringLiteral("Get"), 0);
+        call.setArguments({Hostname1Interface, name});
+        QDBusReply<QVariant> reply = bus.call(call);
+        values.insert(name, reply.value().toString());
+    }
+
+    return values;
+}
+
+void RestoreSetterProperties(const QString& address, const QMap<QString, QString>& values)
+{
+    auto bus = QDBusConnection::connectToBus(address, QStringLiteral("hostnamed-bench-setup"));
+    auto call = QDBusMessage::createMethodCall(Hostname1Service, Hostname1ObjectPath,
+                                               Hostname1Interface, QStringLiteral("SetMachineInfo"));
+    call << QVariant::fromValue(values) << false;
+
+    auto reply = bus.call(call);
+    if (reply.type() == QDBusMessage::ErrorMessage)
+        qWarning() << "Could not restore" << SetterProperties << ":" << reply.errorMessage();
+}
+
+bool WaitForService(const QString& address, const QString& service, const QProcess& daemon)
+{
+    auto bus = QDBusConnection::connectToBus(address, QStringLiteral("hostnamed-bench-setup"));
+
+    QDeadlineTimer deadline(StartupTimeout);
+    while (bus.isConnected() && !deadline.hasExpired() && daemon.state() == QProcess::Running) {
+        if (bus.interface()->isServiceRegistered(service))
+            return true;
+        QThread::msleep(50);
+    }
+
+    return false;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    qDBusRegisterMetaType<QMap<QString, QString>>();
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Measures hostnamed latency and throughput over D-Bus"));
+    parser.addHelpOption();
+
+    QCommandLineOption clientsOption(QStringLiteral("clients"),
+                                     QStringLiteral("Number of concurrent client connections."),
+                                     QStringLiteral("n"), QStringLiteral("8"));
+    QCommandLineOption durationOption(QStringLiteral("duration"),
+                                      QStringLiteral("How long to run, in seconds."),
+                                      QStringLiteral("seconds"), QStringLiteral("5"));
+    QCommandLineOption operationsOption(QStringLiteral("operations"),
+                                        QStringLiteral("Comma separated calls to make, out of %1.")
+                                            .arg((DefaultOperations + SetterOperations).join(QStringLiteral(", "))),
+                                        QStringLiteral("list"), DefaultOperations.join(u','));
+    QCommandLineOption settersOption(QStringLiteral("setters"),
+                                     QStringLiteral("Also call the setters. They modify /etc/machine-info of this host."));
+    QCommandLineOption daemonOption(QStringLiteral("daemon"),
+                                    QStringLiteral("hostnamed binary to run."),
+                                    QStringLiteral("path"), QStringLiteral(HOSTNAMED_PATH));
+    QCommandLineOption dbusDaemonOption(QStringLiteral("dbus-daemon"),
+                                        QStringLiteral("dbus-daemon binary to run the private bus with."),
+                                        QStringLiteral("path"), QStringLiteral("dbus-daemon"));
+    QCommandLineOption mockPolkitOption(QStringLiteral("mock-polkit"),
+                                        QStringLiteral("Run mock-polkit on the private bus. Without it, calls that "
+                                                       "need polkit fail unless run as root."));
+    QCommandLineOption polkitLatencyOption(QStringLiteral("polkit-latency"),
+                                           QStringLiteral("Delay of every mock-polkit answer, in milliseconds."),
+                                           QStringLiteral("ms"), QStringLiteral("0"));
+    QCommandLineOption polkitJitterOption(QStringLiteral("polkit-jitter"),
+                                          QStringLiteral("Extra random delay of mock-polkit answers, in milliseconds."),
+                                          QStringLiteral("ms"), QStringLiteral("0"));
+    QCommandLineOption polkitRuleOption(QStringLiteral("polkit-rule"),
+                                        QStringLiteral("Rule passed on to mock-polkit, see mock-polkit --help."),
+                                        QStringLiteral("rule"));
+    QCommandLineOption outputOption(QStringLiteral("output"),
+                                    QStringLiteral("Write the JSON report to a file instead of stdout."),
+                                    QStringLiteral("path"));
+    parser.addOptions({clientsOption, durationOption, operationsOption, settersOption,
+                       daemonOption, dbusDaemonOption, mockPolkitOption, polkitLatencyOption,
+                       polkitJitterOption, polkitRuleOption, outputOption});
+    parser.process(app);
+
+    const int clients = std::max(1, parser.value(clientsOption).toInt());
+    const double duration = std::max(0.1, parser.value(durationOption).toDouble());
+
+    QStringList operations = parser.value(operationsOption).split(u',', Qt::SkipEmptyParts);
+    if (parser.isSet(settersOption) && !parser.isSet(operationsOption))
+        operations += SetterOperations;
+    for (const auto& operation : std::as_const(operations)) {
+        bool isSetter = SetterOperations.contains(operation);
+        if ((!isSetter && !DefaultOperations.contains(operation)) || (isSetter && !parser.isSet(settersOption))) {
+            qCritical() << "Unsupported operation" << operation << "(setters need --setters)";
+            return 1;
+        }
+    }
+
+    QTemporaryDir runtimeDir;
+    if (!runtimeDir.isValid()) {
+        qCritical() << "Could not create a runtime directory";
+        return 1;
+    }
+
+    // The session configuration lets anyone own any name, which is all the
+    // daemon needs. The bus prints its address once it is listening.
+    QProcess bus;
+    bus.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    bus.start(parser.value(dbusDaemonOption),
+              {QStringLiteral("--session"),
+               QStringLiteral("--nofork"),
+               QStringLiteral("--print-address"),
+               QStringLiteral("--address=unix:path=") + runtimeDir.filePath(QStringLiteral("bus"))});
+    if (!bus.waitForStarted() || !bus.waitForReadyRead(std::chrono::milliseconds(StartupTimeout).count())) {
+        qCritical() << "Could not start" << parser.value(dbusDaemonOption);
+        return 1;
+    }
+    const QString address = QString::fromUtf8(bus.readLine().trimmed());
+
+    // QDBusConnection::systemBus() honours DBUS_SYSTEM_BUS_ADDRESS
+    auto env = QProcessEnvironment::systemEnvironment();
+    env.insert(QStringLiteral("DBUS_SYSTEM_BUS_ADDRESS"), address);
+
+    // hostnamed finds polkit on the bus it serves, so the mock has to be
+    // there first
+    QProcess polkit;
+    if (parser.isSet(mockPolkitOption)) {
+        QStringList args = {
+            QStringLiteral("--latency"), parser.value(polkitLatencyOption),
+            QStringLiteral("--jitter"), parser.value(polkitJitterOption),
+        };
+        for (const auto& rule : parser.values(polkitRuleOption))
+            args << QStringLiteral("--rule") << rule;
+
+        polkit.setProcessEnvironment(env);
+        polkit.setProcessChannelMode(QProcess::ForwardedChannels);
+        polkit.start(QStringLiteral(MOCK_POLKIT_PATH), args);
+    }
+
+    QProcess daemon;
+    daemon.setProcessEnvironment(env);
+    daemon.setProcessChannelMode(QProcess::ForwardedChannels);
+
+    bool ready = true;
+    if (parser.isSet(mockPolkitOption)
+        && (!polkit.waitForStarted() || !WaitForService(address, PolkitService, polkit))) {
+        qCritical() << "mock-polkit did not show up on" << address;
+        ready = false;
+    }
+
+    if (ready) {
+        daemon.start(parser.value(daemonOption), {});
+        if (!daemon.waitForStarted() || !WaitForService(address, Hostname1Service, daemon)) {
+            qCritical() << "hostnamed did not show up on" << address;
+            ready = false;
+        }
+    }
+
+    int ret = 0;
+
+    if (!ready) {
+        ret = 1;
+    } else {
+        QMap<QString, QString> saved;
+        if (parser.isSet(settersOption))
+            saved = SaveSetterProperties(address);
+
+        qInfo() << "Running" << clients << "clients for" << duration << "seconds against" << address;
+
+        QDeadlineTimer deadline(qint64(duration * 1000));
+        QList<Results> clientResults(clients);
+        QList<QThread*> threads;
+        for (int i = 0; i < clients; i++) {
+            threads << QThread::create([&, i] {
+                clientResults[i] = RunClient(address, i, operations, deadline);
+            });
+            threads.last()->start();
+        }
+
+        auto start = Clock::now();
+        for (auto* thread : std::as_const(threads)) {
+            thread->wait();
+            delete thread;
+        }
+        std::chrono::duration<double> elapsed = Clock::now() - start;
+
+        if (parser.isSet(settersOption))
+            RestoreSetterProperties(address, saved);
+
+        Results merged;
+        Samples total;
+        for (const auto& results : std::as_const(clientResults)) {
+            for (auto it = results.cbegin(); it != results.cend(); ++it) {
+                merged[it.key()].latencies += it->latencies;
+                merged[it.key()].errors += it->errors;
+                total.latencies += it->latencies;
+                total.errors += it->errors;
+            }
+        }
+
+        QJsonObject perOperation;
+        for (auto it = merged.cbegin(); it != merged.cend(); ++it)
+            perOperation.insert(it.key(), Summarize(it.value(), elapsed.count()));
+
+        QJsonObject report = {
+            {QStringLiteral("clients"), clients},
+            {QStringLiteral("duration_s"), elapsed.count()},
+            {QStringLiteral("total"), Summarize(total, elapsed.count())},
+            {QStringLiteral("operations"), perOperation},
+        };
+        QByteArray json = QJsonDocument(report).toJson();
+
+        QFile output;
+        bool opened = parser.isSet(outputOption)
+            ? (output.setFileName(parser.value(outputOption)), output.open(QIODevice::WriteOnly))
+            : output.open(stdout, QIODevice::WriteOnly);
+        if (!opened || output.write(json) != json.size()) {
+            qCritical() << "Could not write the report";
+            ret = 1;
+        }
+    }
+
+    QDBusConnection::disconnectFromBus(QStringLiteral("hostnamed-bench-setup"));
+
+    for (auto* process : {&daemon, &polkit}) {
+        if (process->state() == QProcess::NotRunning)
+            continue;
+        process->terminate();
+        if (!process->waitForFinished())
+            process->kill();
+    }
+    bus.terminate();
+    if (!bus.waitForFinished())
+        bus.kill();
+
+    return ret;
+}
@@ -0,0 +1,246 @@
+/*
+ * Copyright (c) 2026 FreeBSD Foundation
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <chrono>
+#include <optional>
+#include <random>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDBusArgument>
+#include <QDBusConnection>
+#include <QDBusContext>
+#include <QDBusMessage>
+#include <QDBusMetaType>
+#include <QRegularExpression>
+#include <QTimer>
+
+// Stand-in for org.freedesktop.PolicyKit1 on a private bus. Answers
+// CheckAuthorization from a list of rules, after an injected delay, so that
+// AuthQueue can be measured without a real polkit and with known latencies.
+
+static const QString PolkitService = QStringLiteral("org.freedesktop.PolicyKit1");
+static const QString PolkitObjectPath = QStringLiteral("/org/freedesktop/PolicyKit1/Authority");
+
+using DetailsMap = QMap<QString, QString>;
+
+// (sa{sv})
+struct PolkitSubject
+{
+    QString kind;
+    QVariantMap details;
+};
+Q_DECLARE_METATYPE(PolkitSubject)
+
+// (bba{ss})
+struct PolkitAuthorizationResult
+{
+    bool isAuthorized = false;
+    bool isChallenge = false;
+    DetailsMap details;
+};
+Q_DECLARE_METATYPE(PolkitAuthorizationResult)
+
+QDBusArgument& operator<<(QDBusArgument& arg, const PolkitSubject& subject)
+{
+    arg.beginStructure();
+    arg << subject.kind << subject.details;
+    arg.endStructure();
+    return arg;
+}
+
+const QDBusArgument& operator>>(const QDBusArgument& arg, PolkitSubject& subject)
+{
+    arg.beginStructure();
+    arg >> subject.kind >> subject.details;
+    arg.endStructure();
+    return arg;
+}
+
+QDBusArgument& operator<<(QDBusArgument& arg, const PolkitAuthorizationResult& result)
+{
+    arg.beginStructure();
+    arg << result.isAuthorized << result.isChallenge << result.details;
+    arg.endStructure();
+    return arg;
+}
+
+const QDBusArgument& operator>>(const QDBusArgument& arg, PolkitAuthorizationResult& result)
+{
+    arg.beginStructure();
+    arg >> result.isAuthorized >> result.isChallenge >> result.details;
+    arg.endStructure();
+    return arg;
+}
+
+class MockAuthority : public QObject,
+                      protected QDBusContext
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.freedesktop.PolicyKit1.Authority")
+public:
+    enum class Decision { Allow, Deny, Challenge };
+
+    struct Rule
+    {
+        QRegularExpression actionId;
+        Decision decision;
+    };
+
+    MockAuthority(QList<Rule> rules, Decision fallback,
+                  std::chrono::milliseconds latency, std::chrono::milliseconds jitter,
+                  uint seed)
+        : m_rules(std::move(rules))
+        , m_fallback(fallback)
+        , m_latency(latency)
+        , m_jitter(jitter)
+        , m_random(seed)
+    {
+    }
+
+public Q_SLOTS:
+    PolkitAuthorizationResult CheckAuthorization(const PolkitSubject& subject,
+                                                 const QString& actionId,
+                                                 const QMap<QString, QString>& details,
+                                                 uint flags,
+                                                 const QString& cancellationId)
+    {
+        Q_UNUSED(subject);
+        Q_UNUSED(details);
+        Q_UNUSED(flags);
+        Q_UNUSED(cancellationId);
+
+        PolkitAuthorizationResult result;
+        switch (decide(actionId)) {
+        case Decision::Allow:
+            result.isAuthorized = true;
+            break;
+        case Decision::Challenge:
+            result.isChallenge = true;
+            break;
+        case Decision::Deny:
+            break;
+        }
+
+        auto delay = m_latency;
+        if (m_jitter.count() > 0)
+            delay += std::chrono::milliseconds(std::uniform_int_distribution<qint64>(0, m_jitter.count())(m_random));
+
+        if (delay.count() == 0)
+            return result;
+
+        setDelayedReply(true);
+        QTimer::singleShot(delay, this, [bus = connection(), reply = message().createReply(QVariant::fromValue(result))] {
+            bus.send(reply);
+        });
+        return {};
+    }
+
+    void CancelCheckAuthorization(const QString& cancellationId)
+    {
+        Q_UNUSED(cancellationId);
+    }
+
+private:
+    Decision decide(const QString& actionId) const
+    {
+        for (const auto& rule : m_rules)
+            if (rule.actionId.match(actionId).hasMatch())
+                return rule.decision;
+        return m_fallback;
+    }
+
+    QList<Rule> m_rules;
+    Decision m_fallback;
+    std::chrono::milliseconds m_latency;
+    std::chrono::milliseconds m_jitter;
+    std::mt19937 m_random;
+};
+
+static std::optional<MockAuthority::Decision> ParseDecision(const QString& name)
+{
+    if (name == QLatin1String("allow"))
+        return MockAuthority::Decision::Allow;
+    if (name == QLatin1String("deny"))
+        return MockAuthority::Decision::Deny;
+    if (name == QLatin1String("challenge"))
+        return MockAuthority::Decision::Challenge;
+    return std::nullopt;
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    qDBusRegisterMetaType<PolkitSubject>();
+    qDBusRegisterMetaType<PolkitAuthorizationResult>();
+    qDBusRegisterMetaType<DetailsMap>();
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Answers polkit CheckAuthorization calls from fixed rules"));
+    parser.addHelpOption();
+
+    QCommandLineOption addressOption(QStringLiteral("address"),
+                                     QStringLiteral("Bus to serve, the system bus (DBUS_SYSTEM_BUS_ADDRESS) by default."),
+                                     QStringLiteral("address"));
+    QCommandLineOption ruleOption(QStringLiteral("rule"),
+                                  QStringLiteral("PATTERN=allow|deny|challenge, where PATTERN is a wildcard on the "
+                                                 "action id. Can be given several times, the first match wins."),
+                                  QStringLiteral("rule"));
+    QCommandLineOption defaultOption(QStringLiteral("default"),
+                                     QStringLiteral("Decision when no rule matches."),
+                                     QStringLiteral("decision"), QStringLiteral("allow"));
+    QCommandLineOption latencyOption(QStringLiteral("latency"),
+                                     QStringLiteral("Delay of every answer, in milliseconds."),
+                                     QStringLiteral("ms"), QStringLiteral("0"));
+    QCommandLineOption jitterOption(QStringLiteral("jitter"),
+                                    QStringLiteral("Uniformly distributed extra delay, in milliseconds."),
+                                    QStringLiteral("ms"), QStringLiteral("0"));
+    QCommandLineOption seedOption(QStringLiteral("seed"),
+                                  QStringLiteral("Seed of the jitter, for repeatable runs."),
+                                  QStringLiteral("n"), QStringLiteral("1"));
+    parser.addOptions({addressOption, ruleOption, defaultOption, latencyOption, jitterOption, seedOption});
+    parser.process(app);
+
+    QList<MockAuthority::Rule> rules;
+    for (const auto& rule : parser.values(ruleOption)) {
+        auto pattern = rule.section(u'=', 0, -2);
+        auto decision = ParseDecision(rule.section(u'=', -1));
+        if (pattern.isEmpty() || !decision) {
+            qCritical() << "Invalid rule" << rule;
+            return 1;
+        }
+        rules.append({QRegularExpression(QRegularExpression::wildcardToRegularExpression(pattern)), *decision});
+    }
+
+    auto fallback = ParseDecision(parser.value(defaultOption));
+    if (!fallback) {
+        qCritical() << "Invalid default decision" << parser.value(defaultOption);
+        return 1;
+    }
+
+    MockAuthority authority(rules, *fallback,
+                            std::chrono::milliseconds(parser.value(latencyOption).toLongLong()),
+                            std::chrono::milliseconds(parser.value(jitterOption).toLongLong()),
+                            parser.value(seedOption).toUInt());
+
+    auto bus = parser.isSet(addressOption)
+        ? QDBusConnection::connectToBus(parser.value(addressOption), QStringLiteral("mock-polkit"))
+        : QDBusConnection::systemBus();
+
+    if (!bus.registerObject(PolkitObjectPath, &authority, QDBusConnection::ExportAllSlots)) {
+        qCritical() << "Could not register" << PolkitObjectPath << "object";
+        return 1;
+    }
+
+    if (!bus.registerService(PolkitService)) {
+        qCritical() << "Could not register" << PolkitService << "service";
+        return 1;
+    }
+
+    return app.exec();
+}
+
+#include "mock-polkit.moc"
@@ -0,0 +1,63 @@
+option(ENABLE_PROBES "Build static DTrace (FreeBSD) or USDT (Linux) probes, see lib/probes.d" OFF)
+
+set(PROBES_DEFINITION "${CMAKE_SOURCE_DIR}/lib/probes.d")
+
+if(ENABLE_PROBES)
+    # on Linux the one from SystemTap, which emits USDT probes with semaphores
+    find_program(DTRACE_EXECUTABLE dtrace REQUIRED)
+    if(NOT CMAKE_SYSTEM_NAME STREQUAL "FreeBSD")
+        include(CheckIncludeFileCXX)
+        check_include_file_cxx(sys/sdt.h HAVE_SYS_SDT_H)
+        if(NOT HAVE_SYS_SDT_H)
+            message(FATAL_ERROR "ENABLE_PROBES requires sys/sdt.h from SystemTap")
+        endif()
+    endif()
+endif()
+
+# Compiles the PROBE() sites of target in, through the macros dtrace -h
+# generates from probes.d.
+# On FreeBSD, before linking, dtrace -G patches the call sites of the
+# target's objects and emits an object describing them, which everything
+# linking the target has to link as well.
+# On Linux dtrace -G emits the probe semaphores, which must exist only once,
+# so they go into the first target only and reach the others through it.
+function(target_probes target)
+    if(NOT ENABLE_PROBES)
+        return()
+    endif()
+
+    target_compile_definitions(${target} PRIVATE HAVE_PROBES)
+
+    set(probes_header "${CMAKE_CURRENT_BINARY_DIR}/HostnamedProbes.h")
+    if(NOT TARGET probes_header)
+        add_custom_command(OUTPUT ${probes_header}
+            COMMAND ${DTRACE_EXECUTABLE} -h -s ${PROBES_DEFINITION} -o ${probes_header}
+            DEPENDS ${PROBES_DEFINITION}
+        )
+        add_custom_target(probes_header DEPENDS ${probes_header})
+    endif()
+    add_dependencies(${target} probes_header)
+
+    if(NOT CMAKE_SYSTEM_NAME STREQUAL "FreeBSD")
+        get_property(have_semaphores GLOBAL PROPERTY PROBES_SEMAPHORES_TARGET SET)
+        if(have_semaphores)
+            return()
+        endif()
+        set_property(GLOBAL PROPERTY PROBES_SEMAPHORES_TARGET ${target})
+
+        set(semaphores_object "${CMAKE_CURRENT_BINARY_DIR}/HostnamedProbes.o")
+        add_custom_command(OUTPUT ${semaphores_object}
+            COMMAND ${DTRACE_EXECUTABLE} -G -s ${PROBES_DEFINITION} -o ${semaphores_object}
+            DEPENDS ${PROBES_DEFINITION}
+        )
+        target_sources(${target} PRIVATE ${semaphores_object})
+        return()
+    endif()
+
+    set(probes_object "${CMAKE_CURRENT_BINARY_DIR}/${target}Probes.o")
+    add_custom_command(TARGET ${target} PRE_LINK
+        COMMAND ${DTRACE_EXECUTABLE} -G -s ${PROBES_DEFINITION} -o ${probes_object} $<TARGET_OBJECTS:${target}>
+        COMMAND_EXPAND_LISTS
+    )
+    target_link_options(${target} INTERFACE ${probes_object})
+endfunction()
@@ -28,14 +28,85 @@
 */
 
 #include "AuthQueue"
+#include "CredentialsCache.h"
+#include "Probes.h"
 
+#include <QDBusArgument>
 #include <QDBusConnection>
-#include <QDBusConnectionInterface>
 #include <QDBusContext>
+#include <QDBusMetaType>
+#include <QDebug>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
+#include <algorithm>
+#include <limits>
 #include <utility>
 
 using namespace PolkitQt1;
 
+static const QString PolkitService = QStringLiteral("org.freedesktop.PolicyKit1");
+static const QString PolkitObjectPath = QStringLiteral("/org/freedesktop/PolicyKit1/Authority");
+static const QString PolkitInterface = QStringLiteral("org.freedesktop.PolicyKit1.Authority");
+
+// CheckAuthorizationFlags
+static constexpr uint PolkitAllowUserInteraction = 0x1;
+
+// Upper bound of concurrent checks, so that a burst of requests doesn't flood polkit
+static constexpr int MaxInFlight = 32;
+
+// Same as polkit's own auth_admin_keep
+static constexpr std::chrono::minutes DecisionLifetime{5};
+static constexpr qsizetype MaxCachedDecisions = 1024;
+
+// (sa{sv})
+struct PolkitSubject
+{
+    QString kind;
+    QVariantMap details;
+};
+Q_DECLARE_METATYPE(PolkitSubject)
+
+// (bba{ss})
+struct PolkitAuthorizationResult
+{
+    bool isAuthorized = false;
+    bool isChallenge = false;
+    DetailsMap details;
+};
+Q_DECLARE_METATYPE(PolkitAuthorizationResult)
+
+QDBusArgument& operator<<(QDBusArgument& arg, const PolkitSubject& subject)
+{
+    arg.beginStructure();
+    arg << subject.kind << subject.details;
+    arg.endStructure();
+    return arg;
+}
+
+const QDBusArgument& operator>>(const QDBusArgument& arg, PolkitSubject& subject)
+{
+    arg.beginStructure();
+    arg >> subject.kind >> subject.details;
+    arg.endStructure();
+    return arg;
+}
+
+QDBusArgument& operator<<(QDBusArgument& arg, const PolkitAuthorizationResult& result)
+{
+    arg.beginStructure();
+    arg << result.isAuthorized << result.isChallenge << result.details;
+    arg.endStructure();
+    return arg;
+}
+
+const QDBusArgument& operator>>(const QDBusArgument& arg, PolkitAuthorizationResult& result)
+{
+    arg.beginStructure();
+    arg >> result.isAuthorized >> result.isChallenge >> result.details;
+    arg.endStructure();
+    return arg;
+}
+
 AuthQueue * AuthQueue::getInstance()
 {
     static auto instance = std::unique_ptr<AuthQueue>(new AuthQueue);
@@ -45,24 +116,7 @@ AuthQueue * AuthQueue::getInstance()
 void AuthQueue::Enqueue(const QString & actionId, const QDBusContext * context,
                         OnBeforeContinuationCheck beforeContinuationCheck, Continuation continuation)
 {
-    if (!context || !context->calledFromDBus())
-    {
-        Item item{actionId, {}, DBusSavedContext(), std::move(beforeContinuationCheck), std::move(continuation)};
-        return callBack(item, PolkitQt1::Authority::Result::No);
-    }
-
-    // bypass Polkit completely when asking authorization for root
-    auto caller = context->connection().interface()->serviceUid(context->message().service());
-    if (caller == 0) {
-        Item item{actionId, {}, DBusSavedContext(context), {}, std::move(continuation)};
-        return callBack(item, PolkitQt1::Authority::Result::Yes);
-    }
-
-    Item item{actionId, {}, DBusSavedContext(context), std::move(beforeContinuationCheck), std::move(continuation)};
-
-    m_items.enqueue(item);
-    if (m_items.size() == 1)
-        dispatchItem();
+    EnqueueWithDetails(actionId, {}, context, std::move(beforeContinuationCheck), std::move(continuation));
 }
 
 void AuthQueue::EnqueueWithDetails(const QString & actionId,
@@ -77,33 +131,135 @@ void AuthQueue::EnqueueWithDetails(const QString & actionId,
         return callBack(item, Authority::Result::No);
     }
 
-    // bypass Polkit completely when asking authorization for root
-    auto caller = context->connection().interface()->serviceUid(context->message().service());
-    if (caller == 0) {
-        Item item{actionId, {}, DBusSavedContext(context), {}, std::move(continuation)};
-        return callBack(item, PolkitQt1::Authority::Result::Yes);
-    }
+    EnqueueWithDetails(actionId, details, DBusSavedContext(context),
+                       std::move(beforeContinuationCheck), std::move(continuation));
+}
+
+void AuthQueue::Enqueue(const QString & actionId, const DBusSavedContext & context,
+                        OnBeforeContinuationCheck beforeContinuationCheck, Continuation continuation)
+{
+    EnqueueWithDetails(actionId, {}, context, std::move(beforeContinuationCheck), std::move(continuation));
+}
+
+void AuthQueue::EnqueueWithDetails(const QString & actionId,
+                                   const DetailsMap& details,
+                                   const DBusSavedContext & context,
+                                   OnBeforeContinuationCheck beforeContinuationCheck,
+                                   Continuation continuation)
+{
+    PROBE(AUTHQUEUE_ENQUEUE, qUtf8Printable(actionId), qUtf8Printable(context.message().service()));
 
     Item item{actionId, details, DBusSavedContext(context), std::move(beforeContinuationCheck), std::move(continuation)};
 
-    m_items.enqueue(item);
-    if (m_items.size() == 1)
-        dispatchItem();
+    // bypass Polkit completely when asking authorization for root
+    auto caller = context.message().service();
+    CredentialsCache::getInstance()->Lookup(context.connection(), caller, [this, item = std::move(item)](const auto& creds) {
+        if (creds.isValid() && creds.uid == 0)
+            return callBack(item, Authority::Result::Yes);
+
+        enqueueItem(item);
+    });
 }
 
-void AuthQueue::onCheckAuthorizationFinished(Authority::Result result)
+void AuthQueue::enqueueItem(Item item)
 {
-    Item item = m_items.dequeue();
+    if (hasCachedDecision(item))
+        return callBack(item, Authority::Result::Yes);
+
+    // A non-interactive check can't stand in for an interactive one and vice versa
+    auto key = decisionKey(item);
+    bool interactive = item.context.message().isInteractiveAuthorizationAllowed();
+    auto followers = m_followers.find(key);
+    if (followers != m_followers.end()) {
+        if (followers->interactive == interactive)
+            return followers->items.append(std::move(item));
+    } else {
+        m_followers.insert(key, {interactive, {}});
+        item.leader = true;
+    }
+
+    if (m_inFlight < MaxInFlight)
+        dispatchItem(std::move(item));
+    else
+        m_items.enqueue(std::move(item));
+}
+
+void AuthQueue::onCheckAuthorizationFinished(const Item& item, Authority::Result result)
+{
+    PROBE(AUTHQUEUE_FINISHED, qUtf8Printable(item.actionId),
+          qUtf8Printable(item.context.message().service()), int(result));
+
+    m_inFlight--;
 
     // start next authentication eagerly
     if (!m_items.empty())
-        dispatchItem();
+        dispatchItem(m_items.dequeue());
+
+    if (result == Authority::Result::Yes)
+        cacheDecision(item);
+
+    QList<Item> followers;
+    if (item.leader)
+        followers = m_followers.take(decisionKey(item)).items;
 
     callBack(item, result);
+
+    for (const auto& follower : std::as_const(followers))
+        callBack(follower, result);
+}
+
+AuthQueue::DecisionKey AuthQueue::decisionKey(const Item& item)
+{
+    return {item.context.message().service(), item.actionId, item.details};
+}
+
+size_t qHash(const AuthQueue::DecisionKey& key, size_t seed)
+{
+    seed = qHashMulti(seed, key.caller, key.actionId);
+    for (auto it = key.details.cbegin(); it != key.details.cend(); ++it)
+        seed = qHashMulti(seed, it.key(), it.value());
+    return seed;
+}
+
+bool AuthQueue::hasCachedDecision(const Item& item)
+{
+    auto it = m_decisions.find(decisionKey(item));
+    if (it == m_decisions.end())
+        return false;
+
+    if (it->hasExpired()) {
+        m_decisions.erase(it);
+        return false;
+    }
+
+    return true;
+}
+
+void AuthQueue::cacheDecision(const Item& item)
+{
+    if (m_decisions.size() >= MaxCachedDecisions) {
+        m_decisions.removeIf([](const auto& it) { return it.value().hasExpired(); });
+
+        // still full, make room by dropping the entry closest to expiry
+        if (m_decisions.size() >= MaxCachedDecisions) {
+            auto oldest = std::min_element(m_decisions.begin(), m_decisions.end());
+            m_decisions.erase(oldest);
+        }
+    }
+
+    m_decisions.insert(decisionKey(item), QDeadlineTimer(DecisionLifetime));
+}
+
+void AuthQueue::onCallerVanished(const QString& caller)
+{
+    m_decisions.removeIf([&caller](const auto& it) { return it.key().caller == caller; });
 }
 
 void AuthQueue::callBack(const Item& item, Authority::Result result)
 {
+    PROBE(AUTHQUEUE_CALLBACK, qUtf8Printable(item.actionId),
+          qUtf8Printable(item.context.message().service()), int(result));
+
     if (item.canContinue && !std::invoke(item.canContinue))
     {
         return;
@@ -115,24 +271,60 @@ void AuthQueue::callBack(const Item& item, Authority::Result result)
     }
 }
 
-void AuthQueue::dispatchItem()
+// PolkitQt1::Authority reports every check through a single signal and thus
+// can only have one in flight. Talk to polkit directly instead, so that every
+// reply carries its own request.
+void AuthQueue::dispatchItem(Item item)
 {
-    const Item & item = m_items.head();
-    auto subject = SystemBusNameSubject(item.context.message().service());
-    Authority::AuthorizationFlags flags = item.context.message().isInteractiveAuthorizationAllowed()
-                                                  ? Authority::AllowUserInteraction
-                                                  : Authority::None;
-    if (item.details.isEmpty())
-        m_authority->checkAuthorization(item.actionId, subject, flags);
-    else
-        m_authority->checkAuthorizationWithDetails(item.actionId, subject, flags, item.details);
+    m_inFlight++;
+    PROBE(AUTHQUEUE_DISPATCH, qUtf8Printable(item.actionId),
+          qUtf8Printable(item.context.message().service()), m_inFlight);
+
+    PolkitSubject subject{QStringLiteral("system-bus-name"),
+                          {{QStringLiteral("name"), item.context.message().service()}}};
+    uint flags = item.context.message().isInteractiveAuthorizationAllowed()
+                         ? PolkitAllowUserInteraction
+                         : 0;
+
+    auto msg = QDBusMessage::createMethodCall(PolkitService, PolkitObjectPath, PolkitInterface,
+                                              QStringLiteral("CheckAuthorization"));
+    msg << QVariant::fromValue(subject)
+        << item.actionId
+        << QVariant::fromValue(item.details)
+        << flags
+        << QString();
+
+    // an interactive check lasts as long as the user takes to authenticate
+    auto pending = item.context.connection().asyncCall(msg, std::numeric_limits<int>::max());
+    auto* watcher = new QDBusPendingCallWatcher(pending);
+    auto sent = std::chrono::steady_clock::now();
+
+    QObject::connect(watcher, &QDBusPendingCallWatcher::finished, [this, sent, item = std::move(item)](auto* call) {
+        QDBusPendingReply<PolkitAuthorizationResult> reply = *call;
+        call->deleteLater();
+        m_polkitWait.Record(std::chrono::steady_clock::now() - sent);
+
+        Authority::Result result = Authority::Result::Unknown;
+        if (reply.isError())
+            qWarning() << "Polkit authorization check failed:" << reply.error().message();
+        else if (reply.value().isAuthorized)
+            result = Authority::Result::Yes;
+        else if (reply.value().isChallenge)
+            result = Authority::Result::Challenge;
+        else
+            result = Authority::Result::No;
+
+        onCheckAuthorizationFinished(item, result);
+    });
 }
 
 AuthQueue::AuthQueue()
 {
-    m_authority = Authority::instance();
+    qDBusRegisterMetaType<PolkitSubject>();
+    qDBusRegisterMetaType<PolkitAuthorizationResult>();
+    qDBusRegisterMetaType<DetailsMap>();
 
-    QObject::connect(m_authority, &Authority::checkAuthorizationFinished, [this](auto result) {
-        onCheckAuthorizationFinished(result);
+    QObject::connect(CredentialsCache::getInstance(), &CredentialsCache::Vanished, [this](const QString& caller) {
+        onCallerVanished(caller);
     });
 }
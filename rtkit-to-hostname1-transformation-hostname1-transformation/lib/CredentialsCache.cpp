@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2026 FreeBSD Foundation
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <QDBusArgument>
+#include <QDBusMessage>
+#include <QDBusPendingCallWatcher>
+#include <QDebug>
+
+#include "CredentialsCache.h"
+
+static const QString DBusService = QStringLiteral("org.freedesktop.DBus");
+static const QString DBusObjectPath = QStringLiteral("/org/freedesktop/DBus");
+static const QString DBusInterface = QStringLiteral("org.freedesktop.DBus");
+
+// Unique names are never reused, so an entry whose disconnect was missed is
+// merely dead weight. Start over rather than letting them pile up.
+static constexpr qsizetype MaxEntries = 4096;
+
+CredentialsCache * CredentialsCache::getInstance()
+{
+    static auto instance = std::unique_ptr<CredentialsCache>(new CredentialsCache);
+    return instance.get();
+}
+
+CredentialsCache::CredentialsCache()
+{
+}
+
+void CredentialsCache::Lookup(const QDBusConnection& connection, const QString& name, Callback callback)
+{
+    auto it = m_credentials.constFind(name);
+    if (it != m_credentials.cend())
+        return callback(*it);
+
+    auto pending = m_pending.find(name);
+    if (pending != m_pending.end())
+        return pending->append(std::move(callback));
+
+    m_pending.insert(name, {std::move(callback)});
+
+    auto msg = QDBusMessage::createMethodCall(DBusService, DBusObjectPath, DBusInterface,
+                                              QStringLiteral("GetConnectionCredentials"));
+    msg << name;
+
+    auto* watcher = new QDBusPendingCallWatcher(connection.asyncCall(msg), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, connection, name](auto* call) {
+        call->deleteLater();
+        onLookupFinished(connection, name, call->reply());
+    });
+}
+
+void CredentialsCache::onLookupFinished(const QDBusConnection& connection, const QString& name,
+                                        const QDBusMessage& reply)
+{
+    auto callbacks = m_pending.take(name);
+
+    Credentials creds;
+    if (reply.type() == QDBusMessage::ErrorMessage) {
+        creds.dbusError = QDBusError(reply);
+    } else {
+        auto values = qdbus_cast<QVariantMap>(reply.arguments().value(0));
+        auto uid = values.value(QStringLiteral("UnixUserID"));
+        auto pid = values.value(QStringLiteral("ProcessID"));
+        if (uid.isValid() && pid.isValid()) {
+            creds.uid = uid.toUInt();
+            creds.pid = pid.toUInt();
+        } else {
+            creds.dbusError = QDBusError(QDBusError::AccessDenied,
+                                         QStringLiteral("Could not determine credentials of %1").arg(name));
+        }
+    }
+
+    // errors are not cached, the name is most likely gone anyway
+    if (creds.isValid()) {
+        // A match rule per name would cost two bus round-trips each and run
+        // into the per-connection limit of the bus daemon. Every disconnect
+        // is a NameOwnerChanged with an empty new owner instead.
+        if (!m_subscribed) {
+            m_subscribed = QDBusConnection(connection).connect(
+                DBusService, DBusObjectPath, DBusInterface, QStringLiteral("NameOwnerChanged"),
+                {QString(), QString(), QStringLiteral("")}, QString(),
+                this, SLOT(onNameOwnerChanged(QString,QString,QString)));
+            if (!m_subscribed)
+                qWarning() << "Could not subscribe to NameOwnerChanged, credentials will not be cached";
+        }
+
+        if (m_credentials.size() >= MaxEntries)
+            clear();
+
+        if (m_subscribed)
+            m_credentials.insert(name, creds);
+    }
+
+    for (const auto& callback : std::as_const(callbacks))
+        callback(creds);
+}
+
+void CredentialsCache::onNameOwnerChanged(const QString& name, const QString& oldOwner,
+                                          const QString& newOwner)
+{
+    Q_UNUSED(oldOwner);
+
+    // released well-known names show up here too
+    if (!newOwner.isEmpty() || !m_credentials.remove(name))
+        return;
+
+    Q_EMIT Vanished(name);
+}
+
+// Everything that is dropped counts as gone for the listeners
+void CredentialsCache::clear()
+{
+    const auto names = m_credentials.keys();
+    m_credentials.clear();
+
+    for (const auto& name : names)
+        Q_EMIT Vanished(name);
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2026 FreeBSD Foundation
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <functional>
+
+#include <sys/types.h>
+
+#include <QDBusConnection>
+#include <QDBusError>
+#include <QHash>
+#include <QObject>
+
+// Mimics QDBusReply, so that DBUS_RETHROW_CONTEXT() can be used on it
+struct Credentials
+{
+    uid_t uid = static_cast<uid_t>(-1);
+    pid_t pid = 0;
+    QDBusError dbusError;
+
+    bool isValid() const { return !dbusError.isValid(); }
+    const QDBusError& error() const { return dbusError; }
+};
+
+// Credentials of the peers on the bus, resolved once per unique name with
+// GetConnectionCredentials and forgotten when the name goes away. Lookups
+// never block: the callback runs once the bus daemon has replied.
+class CredentialsCache : public QObject
+{
+    Q_OBJECT
+protected:
+    CredentialsCache();
+
+public:
+    using Callback = std::function<void(const Credentials&)>;
+
+    static CredentialsCache * getInstance();
+
+    // Calls back right away when the name is known, otherwise after the reply.
+    // Concurrent lookups of the same name share one call to the bus daemon.
+    void Lookup(const QDBusConnection& connection, const QString& name, Callback callback);
+
+Q_SIGNALS:
+    // The peer disconnected, anything cached about it is stale now
+    void Vanished(const QString& name);
+
+private Q_SLOTS:
+    void onNameOwnerChanged(const QString& name, const QString& oldOwner, const QString& newOwner);
+
+private:
+    void onLookupFinished(const QDBusConnection& connection, const QString& name,
+                          const QDBusMessage& reply);
+    void clear();
+
+    QHash<QString, Credentials> m_credentials;
+    // callbacks waiting for a GetConnectionCredentials reply
+    QHash<QString, QList<Callback>> m_pending;
+    // one match rule for all names, see onLookupFinished()
+    bool m_subscribed = false;
+};
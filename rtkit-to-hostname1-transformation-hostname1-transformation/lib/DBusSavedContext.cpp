@@ -30,23 +30,34 @@
 #include <QDBusContext>
 
 #include "DBusSavedContext"
+#include "Stats.h"
 
 DBusSavedContext::DBusSavedContext()
     : m_connection(QDBusConnection::systemBus())
     , m_message()
+    , m_received(std::chrono::steady_clock::now())
 {
 }
 
 DBusSavedContext::DBusSavedContext(const QDBusContext * context)
     : m_connection(context->connection())
     , m_message(context->message())
+    , m_received(CallTimer::HandOff())
 {
     context->setDelayedReply(true);
 }
 
+DBusSavedContext::DBusSavedContext(const QDBusContext * context, std::shared_ptr<ReplyOrder::Ticket> ticket)
+    : DBusSavedContext(context)
+{
+    m_ticket = std::move(ticket);
+}
+
 DBusSavedContext::DBusSavedContext(const DBusSavedContext& context)
     : m_connection(context.m_connection)
     , m_message(context.m_message)
+    , m_received(context.m_received)
+    , m_ticket(context.m_ticket)
 {
 }
 
@@ -62,22 +73,32 @@ const QDBusMessage & DBusSavedContext::message() const
 
 void DBusSavedContext::sendErrorReply(const QString & name, const QString & msg) const
 {
-    m_connection.send(m_message.createErrorReply(name, msg));
+    send(m_message.createErrorReply(name, msg), true);
 }
 
 void DBusSavedContext::sendReply() const
 {
-    m_connection.send(m_message.createReply());
+    send(m_message.createReply(), false);
 }
 
 void DBusSavedContext::sendReply(const QVariant & arg) const
 {
-    m_connection.send((m_message.createReply(arg)));
+    send(m_message.createReply(arg), false);
 }
 
 void DBusSavedContext::sendReply(const QList<QVariant> & args) const
 {
-    m_connection.send((m_message.createReply(args)));
+    send(m_message.createReply(args), false);
+}
+
+void DBusSavedContext::send(const QDBusMessage & reply, bool failed) const
+{
+    if (m_ticket)
+        m_ticket->Send(reply);
+    else
+        m_connection.send(reply);
+
+    CallStats::getInstance()->Record(m_message.member(), std::chrono::steady_clock::now() - m_received, failed);
 }
 
 // no need to do anything here
@@ -4,39 +4,132 @@
  */
 
 #include <QCoreApplication>
-#include <QDateTime>
+#include <QDBusMetaType>
+#include <QScopeGuard>
 
 #include <AuthQueue>
+#include <CredentialsCache.h>
 #include <DBusSavedContext>
 
 #include "Daemon.h"
 #include "Process.h"
+#include "ProcessWatcher.h"
 #include "OSDep.h"
+#include "Probes.h"
 
 #include "RealtimeKit1Adaptor.h"
+#include "RealtimeKit1StatsAdaptor.h"
 
 static const QString RTKitService = QStringLiteral("org.freedesktop.RealtimeKit1");
 static const QString RTKit1ObjectPath = QStringLiteral("/org/freedesktop/RealtimeKit1");
+static const QString AcquireRealtimeAction = QStringLiteral("org.freedesktop.RealtimeKit1.acquire-real-time");
+static const QString AcquireHighPriorityAction = QStringLiteral("org.freedesktop.RealtimeKit1.acquire-high-priority");
+
+// rtkit defaults, 25 requests per 20 seconds
+static constexpr RateLimiter::Policy RequestRate{25.0 / 20, 25};
+
+// More threads than any sane engine has, but few enough to keep a single
+// request from occupying a worker for long
+static constexpr qsizetype MaxBatchSize = 256;
+
+// Process table access is mostly waiting on the kernel, a few threads let
+// other clients get through while one of them runs a long scan
+static constexpr int MaxWorkers = 4;
+
+// Clients with calls in flight are always kept, the orders of those without
+// are dropped once this many have piled up
+static constexpr qsizetype MaxReplyOrders = 256;
+
+QDBusArgument& operator<<(QDBusArgument& arg, const RealtimeThread& thread)
+{
+    arg.beginStructure();
+    arg << thread.thread << thread.priority;
+    arg.endStructure();
+    return arg;
+}
+
+const QDBusArgument& operator>>(const QDBusArgument& arg, RealtimeThread& thread)
+{
+    arg.beginStructure();
+    arg >> thread.thread >> thread.priority;
+    arg.endStructure();
+    return arg;
+}
+
+QDBusArgument& operator<<(QDBusArgument& arg, const HighPriorityThread& thread)
+{
+    arg.beginStructure();
+    arg << thread.thread << thread.priority;
+    arg.endStructure();
+    return arg;
+}
+
+const QDBusArgument& operator>>(const QDBusArgument& arg, HighPriorityThread& thread)
+{
+    arg.beginStructure();
+    arg >> thread.thread >> thread.priority;
+    arg.endStructure();
+    return arg;
+}
+
+static ThreadResult SetThreadPriority(const Process& process, const ThreadPriority& thread,
+                                      PriorityType priorityType)
+{
+    if (!process.ContainsThread(thread.thread))
+        return ThreadResult::NoSuchThread;
+
+    bool ok = false;
+    switch (priorityType)
+    {
+    case PriorityType::High:
+        ok = process.SetHighPriority(thread.thread, thread.priority);
+        break;
+    case PriorityType::Realtime:
+        ok = process.SetRealtimePriority(thread.thread, thread.priority);
+        break;
+    case PriorityType::Idle:
+        ok = process.SetIdlePriority(thread.thread, thread.priority);
+        break;
+    }
+
+    return ok ? ThreadResult::Ok : ThreadResult::Failed;
+}
 
 Daemon::Daemon(const QDBusConnection& bus)
     : m_bus(bus), m_daemonPid(getpid())
 {
+    m_rateLimiter.SetPolicy(AcquireRealtimeAction, RequestRate);
+    m_rateLimiter.SetPolicy(AcquireHighPriorityAction, RequestRate);
+
+    qDBusRegisterMetaType<RealtimeThread>();
+    qDBusRegisterMetaType<RealtimeThreadList>();
+    qDBusRegisterMetaType<HighPriorityThread>();
+    qDBusRegisterMetaType<HighPriorityThreadList>();
+
+    m_pool.setMaxThreadCount(MaxWorkers);
 }
 
 Daemon::~Daemon()
 {
+    m_pool.waitForDone();
+
     OSDep::Fini();
 }
 
 bool Daemon::Start()
 {
     new RealtimeKit1Adaptor(this);
+    new RealtimeKit1StatsAdaptor(this);
+    CallStats::getInstance()->Register(&RealtimeKit1Adaptor::staticMetaObject);
 
     if(!OSDep::Init()) {
         qCritical() << "Could not perform OS-dependend initialization";
         return false;
     }
 
+    m_processWatcher = new ProcessWatcher(this);
+    connect(m_processWatcher, &ProcessWatcher::Exited, this, &Daemon::onProcessExited);
+
     if(!m_bus.registerObject(RTKit1ObjectPath, this)) {
         qCritical() << "Could not register" << RTKit1ObjectPath << "object";
         return false;
@@ -52,174 +145,290 @@ bool Daemon::Start()
 
 void Daemon::Exit()
 {
-    ResetKnown();
+    CallTimer timer(this);
     // StopCanary();
 
-    if (auto* app = QCoreApplication::instance())
-        app->quit();
-    else
-        qWarning() << "No QCoreApplication running, can't Exit()";
+    auto granted = takeGranted();
+
+    runInWorker([=, this] {
+        resetGranted(granted);
+
+        QMetaObject::invokeMethod(this, [] {
+            if (auto* app = QCoreApplication::instance())
+                app->quit();
+            else
+                qWarning() << "No QCoreApplication running, can't Exit()";
+        });
+    });
 }
 
 bool Daemon::SetPriorityAuthorized(const std::shared_ptr<Process>& process,
-                                   qulonglong thread,
+                                   const ThreadPriorities& threads,
                                    PriorityType priorityType,
-                                   qlonglong priorityValue,
                                    uint callerUid,
-                                   const DBusSavedContext* context)
+                                   const DBusSavedContext* context,
+                                   QList<ThreadResult>* results)
 {
+    bool ok = false;
+    PROBE(SET_PRIORITY_ENTRY, process->Pid(), int(priorityType), int(threads.size()));
+    auto probeReturn = qScopeGuard([&] { PROBE(SET_PRIORITY_RETURN, process->Pid(), ok); });
+
     if (!process->IsValid())
         DBUS_THROW_CONTEXT("org.freedesktop.DBus.Error.InvalidArgs", "The requested process was not found");
 
     if (process->Uid() != callerUid)
         DBUS_THROW_CONTEXT ("org.freedesktop.DBus.Error.AccessDenied", "The requested process does not belong to you");
 
-    if (!process->ContainsThread(thread))
-        DBUS_THROW_CONTEXT ("org.freedesktop.DBus.Error.InvalidArgs", "The specified thread does not belong to this process");
-
-    switch (priorityType)
-    {
-    case PriorityType::High:
-        if (!process->SetHighPriority(thread, priorityValue))
-            DBUS_THROW_CONTEXT ("org.freedesktop.DBus.Error.Failed", "Failed to set priority");
-        break;
-    case PriorityType::Realtime:
-        if (!process->SetRealtimePriority(thread, priorityValue))
-            DBUS_THROW_CONTEXT ("org.freedesktop.DBus.Error.Failed", "Failed to set priority");
-        break;
-    case PriorityType::Idle:
-        if (!process->SetIdlePriority(thread, priorityValue))
-            DBUS_THROW_CONTEXT ("org.freedesktop.DBus.Error.Failed", "Failed to set priority");
-        break;
-    default:
-        DBUS_THROW_CONTEXT ("org.freedesktop.DBus.Error.Failed", "Unknown priority type");
+    bool applied = false;
+    results->clear();
+    results->reserve(threads.size());
+    for (const auto& thread : threads) {
+        auto result = SetThreadPriority(*process, thread, priorityType);
+        applied |= result == ThreadResult::Ok;
+        results->append(result);
     }
 
-    if (!process->IsValid()) {
-        process->ResetAllPriorities(thread);
+    if (applied && !process->IsValid()) {
+        for (qsizetype i = 0; i < threads.size(); i++)
+            if (results->at(i) == ThreadResult::Ok)
+                process->ResetAllPriorities(threads[i].thread);
         DBUS_THROW_CONTEXT("org.freedesktop.DBus.Error.InvalidArgs", "The requested process was not found");
     }
 
-    m_knownProcesses.push_back(process);
-
+    ok = true;
     return true;
 }
 
 void Daemon::MakeThreadHighPriority(qulonglong thread, int priority)
 {
-    auto* context = this;
-
-    auto process = connection().interface()->servicePid(message().service());
-    if (!process.isValid())
-        DBUS_RETHROW_CONTEXT_VOID(process);
-
-    MakeThreadHighPriorityWithPID(process, thread, priority);
+    CallTimer timer(this);
+    submit([=, this](auto* context) {
+        requestPriority(0, {{thread, priority}}, PriorityType::High, false, context);
+    });
 }
 
 void Daemon::MakeThreadHighPriorityWithPID(qulonglong process, qulonglong thread, int priority)
 {
-    auto* context = this;
-
-    if (!process)
-        DBUS_THROW_CONTEXT_VOID("org.freedesktop.DBus.Error.InvalidArgs", "The requested process was not found");
+    CallTimer timer(this);
+    submit([=, this](auto* context) {
+        if (!process)
+            DBUS_THROW_CONTEXT_VOID("org.freedesktop.DBus.Error.InvalidArgs", "The requested process was not found");
 
-    auto callerUid = connection().interface()->serviceUid(message().service());
-    if (!callerUid.isValid())
-        DBUS_RETHROW_CONTEXT_VOID(callerUid);
-
-    if (!checkBursting(callerUid))
-        DBUS_THROW_CONTEXT_VOID("org.freedesktop.DBus.Error.AccessDenied", "You are calling too often");
-
-    garbageCollect();
-
-    std::shared_ptr<Process> proc = std::make_shared<Process>(process);
+        requestPriority(process, {{thread, priority}}, PriorityType::High, false, context);
+    });
+}
 
-    AuthQueue::getInstance()->Enqueue(QStringLiteral("org.freedesktop.RealtimeKit1.acquire-high-priority"),
-                                      context, {},
-                                      [=, callerUid=callerUid.value(), this](auto r, auto* context)
-    {
-        if (r != PolkitQt1::Authority::Result::Yes)
-            DBUS_THROW_CONTEXT_VOID("org.freedesktop.DBus.Error.AccessDenied", "You are not allowed to set high priority");
+void Daemon::MakeThreadRealtime(qulonglong thread, uint priority)
+{
+    CallTimer timer(this);
+    submit([=, this](auto* context) {
+        requestPriority(0, {{thread, priority}}, PriorityType::Realtime, false, context);
+    });
+}
 
-        if (!SetPriorityAuthorized(proc, thread, PriorityType::High, priority, callerUid, context))
-            return; // error already reported
+void Daemon::MakeThreadRealtimeWithPID(qulonglong process, qulonglong thread, uint priority)
+{
+    CallTimer timer(this);
+    submit([=, this](auto* context) {
+        if (!process)
+            DBUS_THROW_CONTEXT_VOID("org.freedesktop.DBus.Error.InvalidArgs", "The requested process was not found");
 
-        context->sendReply();
+        requestPriority(process, {{thread, priority}}, PriorityType::Realtime, false, context);
     });
 }
 
-void Daemon::MakeThreadRealtime(qulonglong thread, uint priority)
+QList<bool> Daemon::MakeThreadsHighPriorityWithPID(qulonglong process, const HighPriorityThreadList& threads)
 {
-    auto* context = this;
+    CallTimer timer(this);
+    ThreadPriorities priorities;
+    priorities.reserve(threads.size());
+    for (const auto& thread : threads)
+        priorities.append({thread.thread, thread.priority});
+
+    submit([=, this](auto* context) {
+        if (!process)
+            DBUS_THROW_CONTEXT_VOID("org.freedesktop.DBus.Error.InvalidArgs", "The requested process was not found");
 
-    auto callerUid = connection().interface()->serviceUid(message().service());
-    if (!callerUid.isValid())
-        DBUS_RETHROW_CONTEXT_VOID(callerUid);
+        if (priorities.size() > MaxBatchSize)
+            DBUS_THROW_CONTEXT_VOID("org.freedesktop.DBus.Error.InvalidArgs", "Too many threads");
 
-    auto process = connection().interface()->servicePid(message().service());
-    if (!process.isValid())
-        DBUS_RETHROW_CONTEXT_VOID(process);
+        if (priorities.isEmpty())
+            return context->sendReply(QVariant::fromValue(QList<bool>()));
 
-    MakeThreadRealtimeWithPID(process, thread, priority);
+        requestPriority(process, priorities, PriorityType::High, true, context);
+    });
+    return {};
 }
 
-void Daemon::MakeThreadRealtimeWithPID(qulonglong process, qulonglong thread, uint priority)
+QList<bool> Daemon::MakeThreadsRealtimeWithPID(qulonglong process, const RealtimeThreadList& threads)
 {
-    auto* context = this;
+    CallTimer timer(this);
+    ThreadPriorities priorities;
+    priorities.reserve(threads.size());
+    for (const auto& thread : threads)
+        priorities.append({thread.thread, thread.priority});
 
-    if (!process)
-        DBUS_THROW_CONTEXT_VOID("org.freedesktop.DBus.Error.InvalidArgs", "The requested process was not found");
+    submit([=, this](auto* context) {
+        if (!process)
+            DBUS_THROW_CONTEXT_VOID("org.freedesktop.DBus.Error.InvalidArgs", "The requested process was not found");
 
-    auto callerUid = connection().interface()->serviceUid(message().service());
-    if (!callerUid.isValid())
-        DBUS_RETHROW_CONTEXT_VOID(callerUid);
+        if (priorities.size() > MaxBatchSize)
+            DBUS_THROW_CONTEXT_VOID("org.freedesktop.DBus.Error.InvalidArgs", "Too many threads");
 
-    if (!checkBursting(callerUid))
-        DBUS_THROW_CONTEXT_VOID("org.freedesktop.DBus.Error.AccessDenied", "You are calling too often");
+        if (priorities.isEmpty())
+            return context->sendReply(QVariant::fromValue(QList<bool>()));
 
-    garbageCollect();
+        requestPriority(process, priorities, PriorityType::Realtime, true, context);
+    });
+    return {};
+}
 
-    std::shared_ptr<Process> proc = std::make_shared<Process>(process);
+// Process 0 means the caller's own process. A batch request is authorized and
+// rate limited once and answered with one result per thread.
+void Daemon::requestPriority(qulonglong process, const ThreadPriorities& threads,
+                             PriorityType priorityType, bool batch,
+                             const DBusSavedContext* context)
+{
+    DBusSavedContext saved(*context);
 
-    AuthQueue::getInstance()->Enqueue(QStringLiteral("org.freedesktop.RealtimeKit1.acquire-real-time"),
-                                      context, {},
-                                      [=, callerUid=callerUid.value(), this](auto r, auto* context)
+    CredentialsCache::getInstance()->Lookup(saved.connection(), saved.message().service(),
+                                            [=, this](const Credentials& caller)
     {
-        if (r != PolkitQt1::Authority::Result::Yes)
-            DBUS_THROW_CONTEXT_VOID("org.freedesktop.DBus.Error.AccessDenied", "You are not allowed to set realtime priority");
+        auto* context = &saved;
 
-        if (!SetPriorityAuthorized(proc, thread, PriorityType::Realtime, priority, callerUid, context))
-            return; // error already reported
+        if (!caller.isValid())
+            DBUS_RETHROW_CONTEXT_VOID(caller);
 
-        context->sendReply();
+        onCallerResolved(process ? process : caller.pid, threads, priorityType, batch,
+                         caller.uid, context);
     });
 }
 
-void Daemon::ResetAll()
+void Daemon::onCallerResolved(qulonglong process, const ThreadPriorities& threads,
+                              PriorityType priorityType, bool batch, uid_t callerUid,
+                              const DBusSavedContext* context)
 {
-    Process::ForEach([this](Process* proc) {
-        if (proc->Pid() == m_daemonPid)
-            return;
+    bool realtime = priorityType == PriorityType::Realtime;
+    const auto& actionId = realtime ? AcquireRealtimeAction : AcquireHighPriorityAction;
 
-        if (proc->Uid() == 0)
-            return;
+    if (!m_rateLimiter.Acquire(actionId, callerUid))
+        DBUS_THROW_CONTEXT_VOID("org.freedesktop.DBus.Error.AccessDenied", "You are calling too often");
+
+    DBusSavedContext saved(*context);
+
+    // The process is looked up before asking polkit, so that SetPriorityAuthorized()
+    // can tell whether the pid was reused while the check was pending
+    runInWorker([=, this] {
+        auto proc = std::make_shared<Process>(process);
+
+        QMetaObject::invokeMethod(this, [=, this] {
+            AuthQueue::getInstance()->Enqueue(actionId, saved, {}, [=, this](auto r, auto* context)
+            {
+                if (r != PolkitQt1::Authority::Result::Yes) {
+                    if (realtime)
+                        DBUS_THROW_CONTEXT_VOID("org.freedesktop.DBus.Error.AccessDenied", "You are not allowed to set realtime priority");
+                    DBUS_THROW_CONTEXT_VOID("org.freedesktop.DBus.Error.AccessDenied", "You are not allowed to set high priority");
+                }
+
+                runInWorker([=, this] {
+                    QList<ThreadResult> results;
+                    if (!SetPriorityAuthorized(proc, threads, priorityType, callerUid, &saved, &results))
+                        return; // error already reported
+
+                    QMetaObject::invokeMethod(this, [=, this] {
+                        auto* context = &saved;
+
+                        recordGrants(proc, threads, results, priorityType);
+
+                        if (batch) {
+                            QList<bool> succeeded;
+                            succeeded.reserve(results.size());
+                            for (auto result : results)
+                                succeeded.append(result == ThreadResult::Ok);
+
+                            return context->sendReply(QVariant::fromValue(succeeded));
+                        }
+
+                        switch (results.first())
+                        {
+                        case ThreadResult::NoSuchThread:
+                            DBUS_THROW_CONTEXT_VOID("org.freedesktop.DBus.Error.InvalidArgs", "The specified thread does not belong to this process");
+                        case ThreadResult::Failed:
+                            DBUS_THROW_CONTEXT_VOID("org.freedesktop.DBus.Error.Failed", "Failed to set priority");
+                        default:
+                            context->sendReply();
+                        }
+                    });
+                });
+            });
+        });
+    });
+}
 
-        if (!proc->HasNonStandardSchedulingPolicy())
+void Daemon::recordGrants(const std::shared_ptr<Process>& process, const ThreadPriorities& threads,
+                          const QList<ThreadResult>& results, PriorityType priorityType)
+{
+    // Watched before checking the identity once more, so that an exit
+    // right after the check still removes the entry
+    if (!m_grantedThreads.Contains(*process)) {
+        m_processWatcher->Watch(*process);
+        if (!process->IsValid())
             return;
+    }
 
-        proc->ResetAllPriorities(0);
-    });
+    for (qsizetype i = 0; i < threads.size(); i++)
+        if (results[i] == ThreadResult::Ok)
+            m_grantedThreads.Insert(process, threads[i].thread, priorityType, threads[i].priority);
+}
 
-    garbageCollect();
+void Daemon::ResetAll()
+{
+    CallTimer timer(this);
+    submit([=, this](auto* context) {
+        DBusSavedContext saved(*context);
+
+        runInWorker([=, this] {
+            // each worker keeps its own, so that the storage is reused
+            thread_local QList<OSDep::ProcessState> states;
+            auto scanStarted = std::chrono::steady_clock::now();
+            PROBE(OSDEP_ENTRY, "SnapshotProcesses", 0, 0);
+            OSDep::SnapshotProcesses(states);
+            PROBE(OSDEP_RETURN, "SnapshotProcesses", 0, !states.isEmpty());
+            m_processScan.Record(std::chrono::steady_clock::now() - scanStarted);
+
+            for (const auto& state : std::as_const(states)) {
+                if (state.pid == m_daemonPid)
+                    continue;
+
+                if (state.uid == 0)
+                    continue;
+
+                if (state.schedulingClass == OSDep::SchedulingClass::Normal)
+                    continue;
+
+                PROBE(OSDEP_ENTRY, "ResetAllPriorities", state.pid, 0);
+                bool ok = OSDep::ResetAllPriorities(state.pid, 0);
+                PROBE(OSDEP_RETURN, "ResetAllPriorities", state.pid, ok);
+            }
+
+            saved.sendReply();
+        });
+    });
 }
 
 void Daemon::ResetKnown()
 {
-    for (const auto& proc : m_knownProcesses)
-        if (proc->IsValid())
-            proc->ResetAllPriorities(0);
+    CallTimer timer(this);
+    submit([=, this](auto* context) {
+        DBusSavedContext saved(*context);
+        auto granted = takeGranted();
+
+        runInWorker([=] {
+            resetGranted(granted);
 
-    garbageCollect();
+            saved.sendReply();
+        });
+    });
 }
 
 int Daemon::MaxRealtimePriority() const
@@ -237,32 +446,93 @@ qlonglong Daemon::RTTimeUSecMax() const
     return 0;
 }
 
-void Daemon::garbageCollect()
+QVariantMap Daemon::MethodCalls() const
 {
-    erase_if(m_knownProcesses, [](const auto& proc) {
-        return !proc->IsValid() || !proc->HasNonStandardSchedulingPolicy();
-    });
+    return CallStats::getInstance()->ToVariant();
+}
+
+uint Daemon::AuthQueueDepth() const
+{
+    return AuthQueue::getInstance()->QueueDepth();
+}
+
+uint Daemon::AuthQueueInFlight() const
+{
+    return AuthQueue::getInstance()->InFlight();
 }
 
-bool Daemon::checkBursting(uint userId)
+QVariantMap Daemon::PolkitWait() const
 {
-    // rtkit defaults
-    const auto burstInterval = 20;
-    const auto maxActionsPerBurst = 25;
+    return AuthQueue::getInstance()->PolkitWait().ToVariant();
+}
 
-    auto& bi = m_burstInfos[userId];
-    auto now = QDateTime::currentDateTime().toSecsSinceEpoch();
+qulonglong Daemon::RateLimitRejections() const
+{
+    return m_rateLimiter.Rejected();
+}
 
-    if (now > bi.second + burstInterval) {
-        bi.first = 0;
-        bi.second = now;
-        return true;
+uint Daemon::KnownProcesses() const
+{
+    return m_grantedThreads.ProcessCount();
+}
+
+QVariantMap Daemon::ProcessScan() const
+{
+    return m_processScan.ToVariant();
+}
+
+// Requests run right away, the replies to a client go out in the order of its
+// calls
+void Daemon::submit(const Request& request)
+{
+    auto client = message().service();
+
+    auto order = m_replyOrders.value(client).lock();
+    if (!order) {
+        if (m_replyOrders.size() >= MaxReplyOrders)
+            m_replyOrders.removeIf([](const auto& it) { return it.value().expired(); });
+        order = std::make_shared<ReplyOrder>(connection());
+        m_replyOrders.insert(client, order);
     }
 
-    if (bi.first >= maxActionsPerBurst)
-        return false;
+    DBusSavedContext context(this, order->Next());
+    request(&context);
+}
+
+void Daemon::runInWorker(std::function<void()> f)
+{
+    m_pool.start(std::move(f));
+}
 
-    bi.first++;
+QList<GrantedThreads::Entry> Daemon::takeGranted()
+{
+    auto granted = m_grantedThreads.TakeAll();
+    for (const auto& entry : std::as_const(granted))
+        m_processWatcher->Unwatch(entry.process->Pid());
+    return granted;
+}
 
-    return true;
+void Daemon::resetGranted(const QList<GrantedThreads::Entry>& granted)
+{
+    for (const auto& entry : granted) {
+        const auto& proc = *entry.process;
+        if (!proc.IsValid())
+            continue;
+
+        // a thread id that is gone may already name a thread of another process
+        for (auto it = entry.threads.cbegin(); it != entry.threads.cend(); ++it)
+            if (proc.ContainsThread(it.key()))
+                proc.ResetAllPriorities(it.key());
+    }
+}
+
+void Daemon::onProcessExited(pid_t process)
+{
+    // The pid may already belong to a process granted after the exit happened
+    if (auto* proc = m_grantedThreads.FindPid(process))
+        if (m_processWatcher->Watch(*proc) && proc->IsValid())
+            return;
+
+    m_processWatcher->Unwatch(process);
+    m_grantedThreads.RemovePid(process);
 }
@@ -5,25 +5,63 @@
 
 #pragma once
 
+#include <functional>
+
 #include <sys/types.h>
 
+#include <QDBusArgument>
 #include <QDBusConnection>
 #include <QDBusContext>
 #include <QHash>
-#include <QVector>
+#include <QThreadPool>
+#include <QVariantMap>
+
+#include <DBusSavedContext>
+
+#include "GrantedThreads.h"
+#include "RateLimiter.h"
+#include "ReplyOrder.h"
+#include "Stats.h"
 
-class DBusSavedContext;
 class Process;
+class ProcessWatcher;
 
-enum class PriorityType
+// Elements of MakeThreadsRealtimeWithPID, (tu)
+struct RealtimeThread
 {
-    High,
-    Realtime,
-    Idle
+    qulonglong thread = 0;
+    uint priority = 0;
 };
+Q_DECLARE_METATYPE(RealtimeThread)
+using RealtimeThreadList = QList<RealtimeThread>;
 
-// <amount of actions, timestamp>
-typedef QPair<uint, qulonglong> BurstInfo;
+// Elements of MakeThreadsHighPriorityWithPID, (ti)
+struct HighPriorityThread
+{
+    qulonglong thread = 0;
+    int priority = 0;
+};
+Q_DECLARE_METATYPE(HighPriorityThread)
+using HighPriorityThreadList = QList<HighPriorityThread>;
+
+QDBusArgument& operator<<(QDBusArgument& arg, const RealtimeThread& thread);
+const QDBusArgument& operator>>(const QDBusArgument& arg, RealtimeThread& thread);
+QDBusArgument& operator<<(QDBusArgument& arg, const HighPriorityThread& thread);
+const QDBusArgument& operator>>(const QDBusArgument& arg, HighPriorityThread& thread);
+
+struct ThreadPriority
+{
+    qulonglong thread;
+    qlonglong priority;
+};
+using ThreadPriorities = QList<ThreadPriority>;
+
+enum class ThreadResult
+{
+    Ok,
+    NoSuchThread,
+    Failed
+};
 
 class Daemon : public QObject,
                protected QDBusContext
@@ -35,12 +73,15 @@ public:
 
     bool Start();
 
+    // Validates the process once for all threads. Problems with the process
+    // fail the whole call, those of single threads only show up in results.
+    // Safe to call from any thread, the grants are recorded by the caller.
     bool SetPriorityAuthorized(const std::shared_ptr<Process>& process,
-                               qulonglong thread,
+                               const ThreadPriorities& threads,
                                PriorityType priorityType,
-                               qlonglong priorityValue,
                                uint callerUid,
-                               const DBusSavedContext* context);
+                               const DBusSavedContext* context,
+                               QList<ThreadResult>* results);
 
 public:
     Q_PROPERTY(int MaxRealtimePriority READ MaxRealtimePriority)
@@ -52,21 +93,73 @@ public:
     Q_PROPERTY(qlonglong RTTimeUSecMax READ RTTimeUSecMax)
     qlonglong RTTimeUSecMax() const;
 
+    // org.freedesktop.RealtimeKit1.Stats
+    Q_PROPERTY(QVariantMap MethodCalls READ MethodCalls)
+    QVariantMap MethodCalls() const;
+
+    Q_PROPERTY(uint AuthQueueDepth READ AuthQueueDepth)
+    uint AuthQueueDepth() const;
+
+    Q_PROPERTY(uint AuthQueueInFlight READ AuthQueueInFlight)
+    uint AuthQueueInFlight() const;
+
+    Q_PROPERTY(QVariantMap PolkitWait READ PolkitWait)
+    QVariantMap PolkitWait() const;
+
+    Q_PROPERTY(qulonglong RateLimitRejections READ RateLimitRejections)
+    qulonglong RateLimitRejections() const;
+
+    Q_PROPERTY(uint KnownProcesses READ KnownProcesses)
+    uint KnownProcesses() const;
+
+    Q_PROPERTY(QVariantMap ProcessScan READ ProcessScan)
+    QVariantMap ProcessScan() const;
+
 public Q_SLOTS:
     void Exit();
     void MakeThreadHighPriority(qulonglong thread, int priority);
     void MakeThreadHighPriorityWithPID(qulonglong process, qulonglong thread, int priority);
     void MakeThreadRealtime(qulonglong thread, uint priority);
     void MakeThreadRealtimeWithPID(qulonglong process, qulonglong thread, uint priority);
+    QList<bool> MakeThreadsHighPriorityWithPID(qulonglong process, const HighPriorityThreadList& threads);
+    QList<bool> MakeThreadsRealtimeWithPID(qulonglong process, const RealtimeThreadList& threads);
     void ResetAll();
     void ResetKnown();
 
 private:
-    void garbageCollect();
-    bool checkBursting(uint userId);
+    using Request = std::function<void(const DBusSavedContext* context)>;
+
+    void submit(const Request& request);
+
+    void requestPriority(qulonglong process, const ThreadPriorities& threads,
+                         PriorityType priorityType, bool batch,
+                         const DBusSavedContext* context);
+    void onCallerResolved(qulonglong process, const ThreadPriorities& threads,
+                          PriorityType priorityType, bool batch, uid_t callerUid,
+                          const DBusSavedContext* context);
+    void recordGrants(const std::shared_ptr<Process>& process, const ThreadPriorities& threads,
+                      const QList<ThreadResult>& results, PriorityType priorityType);
+    void runInWorker(std::function<void()> f);
+    QList<GrantedThreads::Entry> takeGranted();
+    static void resetGranted(const QList<GrantedThreads::Entry>& granted);
+    void onProcessExited(pid_t process);
 
     QDBusConnection m_bus;
     pid_t m_daemonPid;
-    QVector<std::shared_ptr<Process>> m_knownProcesses;
-    QHash<uint, BurstInfo> m_burstInfos;
+    RateLimiter m_rateLimiter;
+
+    // Per client, to send the replies in the order of the calls. The tickets
+    // of the calls keep an order alive.
+    QHash<QString, std::weak_ptr<ReplyOrder>> m_replyOrders;
+
+    // Resolving processes, changing priorities and scanning the process table
+    // run here, so that a slow lookup never holds up the event loop
+    QThreadPool m_pool;
+
+    // Only touched from the event loop
+    GrantedThreads m_grantedThreads;
+    ProcessWatcher * m_processWatcher{nullptr};
+
+    // How long ResetAll() takes to go through the process table
+    Histogram m_processScan;
 };
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2026 FreeBSD Foundation
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <QFile>
+
+#include "EnvFile.h"
+
+namespace
+{
+
+QString Unquote(const QByteArray& value)
+{
+    QByteArray out;
+    out.reserve(value.size());
+
+    char quote = 0;
+    for (qsizetype i = 0; i < value.size(); i++) {
+        char c = value[i];
+
+        if (quote == '\'') {
+            if (c == '\'')
+                quote = 0;
+            else
+                out.append(c);
+            continue;
+        }
+
+        if (c == '\\' && i + 1 < value.size()) {
+            out.append(value[++i]);
+            continue;
+        }
+
+        if (c == '"' || (c == '\'' && !quote)) {
+            quote = quote ? 0 : c;
+            continue;
+        }
+
+        out.append(c);
+    }
+
+    return QString::fromUtf8(out);
+}
+
+bool NeedsQuoting(const QString& value)
+{
+    for (QChar c : value)
+        if (!c.isLetterOrNumber() && !QStringLiteral("-_.,:/+@%").contains(c))
+            return true;
+    return value.isEmpty();
+}
+
+}
+
+namespace EnvFile
+{
+
+Values Parse(const QByteArray& contents)
+{
+    Values values;
+
+    for (QByteArray line : contents.split('\n')) {
+        line = line.trimmed();
+        if (line.isEmpty() || line.startsWith('#'))
+            continue;
+
+        auto eq = line.indexOf('=');
+        if (eq <= 0)
+            continue;
+
+        values.insert(QString::fromUtf8(line.left(eq).trimmed()),
+                      Unquote(line.mid(eq + 1).trimmed()));
+    }
+
+    return values;
+}
+
+QByteArray Serialize(const Values& values)
+{
+    QByteArray out;
+
+    for (auto it = values.cbegin(); it != values.cend(); ++it) {
+        out += it.key().toUtf8();
+        out += '=';
+
+        if (!NeedsQuoting(it.value())) {
+            out += it.value().toUtf8();
+        } else {
+            out += '"';
+            for (char c : it.value().toUtf8()) {
+                if (c == '"' || c == '\\' || c == '$' || c == '`')
+                    out += '\\';
+                out += c;
+            }
+            out += '"';
+        }
+
+        out += '\n';
+    }
+
+    return out;
+}
+
+Values Read(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return {};
+
+    return Parse(file.readAll());
+}
+
+}
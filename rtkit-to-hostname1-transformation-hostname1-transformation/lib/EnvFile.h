@@ -0,0 +1,25 @@
+/*
+ * Copyright (c) 2026 FreeBSD Foundation
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QMap>
+#include <QString>
+
+// Parser and serializer for the shell-compatible KEY=VALUE files used by
+// os-release(5) and machine-info(5)
+namespace EnvFile
+{
+
+using Values = QMap<QString, QString>;
+
+Values Parse(const QByteArray& contents);
+QByteArray Serialize(const Values& values);
+
+// A missing file reads as empty
+Values Read(const QString& path);
+
+}
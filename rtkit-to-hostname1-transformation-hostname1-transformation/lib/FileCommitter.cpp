@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2026 FreeBSD Foundation
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <utility>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+#include "FileCommitter.h"
+
+namespace
+{
+
+// A rename or unlink only survives a crash once the directory holding the
+// entry has been synced as well
+bool SyncDirectory(const QString& path)
+{
+    const QByteArray dir = QFile::encodeName(QFileInfo(path).absolutePath());
+    int fd = ::open(dir.constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+
+    bool ok = ::fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+}
+
+}
+
+FileCommitter::FileCommitter(std::chrono::milliseconds window, QObject* parent)
+    : QObject(parent)
+{
+    m_timer.setSingleShot(true);
+    m_timer.setInterval(window);
+    connect(&m_timer, &QTimer::timeout, this, &FileCommitter::Flush);
+
+    // a single thread keeps the commits of a file in order
+    m_pool.setMaxThreadCount(1);
+}
+
+FileCommitter::~FileCommitter()
+{
+    Flush();
+    m_pool.waitForDone();
+}
+
+void FileCommitter::Update(const QString& path, Edit edit, Callback done)
+{
+    auto& pending = m_pending[path];
+    pending.edits.append(std::move(edit));
+    if (done)
+        pending.callbacks.append(std::move(done));
+
+    // the window starts with the first edit, later ones don't push it back
+    if (!m_timer.isActive())
+        m_timer.start();
+}
+
+void FileCommitter::Write(const QString& path, const QByteArray& contents, Callback done)
+{
+    Update(path, [contents](const auto&) { return contents; }, std::move(done));
+}
+
+void FileCommitter::Remove(const QString& path, Callback done)
+{
+    Update(path, [](const auto&) { return std::nullopt; }, std::move(done));
+}
+
+bool FileCommitter::IsPending(const QString& path) const
+{
+    return m_pending.contains(path) || m_committing.contains(path);
+}
+
+void FileCommitter::Flush()
+{
+    m_timer.stop();
+
+    // edits made from now on go into the next window
+    auto pending = std::exchange(m_pending, {});
+
+    for (auto it = pending.cbegin(); it != pending.cend(); ++it) {
+        m_committing[it.key()]++;
+        m_pool.start([this, path = it.key(), edits = it->edits, callbacks = it->callbacks] {
+            bool ok = commit(path, edits);
+            // the destructor waits for us, so this is still alive
+            QMetaObject::invokeMethod(this, [=, this] {
+                onCommitted(path, ok, callbacks);
+            }, Qt::QueuedConnection);
+        });
+    }
+}
+
+void FileCommitter::onCommitted(const QString& path, bool ok, const QList<Callback>& callbacks)
+{
+    auto it = m_committing.find(path);
+    if (--*it == 0)
+        m_committing.erase(it);
+
+    if (!ok)
+        qWarning() << "Failed to commit" << path;
+
+    for (const auto& callback : callbacks)
+        callback(ok);
+}
+
+bool FileCommitter::commit(const QString& path, const QList<Edit>& edits)
+{
+    std::optional<QByteArray> current;
+    QFile file(path);
+    if (file.open(QIODevice::ReadOnly)) {
+        current = file.readAll();
+        // editing what could not be read would throw the rest away
+        if (file.error() != QFileDevice::NoError)
+            return false;
+    } else if (file.exists()) {
+        return false;
+    }
+    file.close();
+
+    auto contents = current;
+    for (const auto& edit : edits)
+        contents = edit(contents);
+
+    if (contents == current)
+        return true;
+
+    if (!contents)
+        return QFile::remove(path) && SyncDirectory(path);
+
+    // QSaveFile writes to a temporary file, fsyncs it and renames it over path
+    QSaveFile saveFile(path);
+    if (!saveFile.open(QIODevice::WriteOnly))
+        return false;
+
+    saveFile.write(*contents);
+
+    return saveFile.commit() && SyncDirectory(path);
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2026 FreeBSD Foundation
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <optional>
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QThreadPool>
+#include <QTimer>
+
+// Collects the edits made to small configuration files during a short window
+// and then commits each file once, atomically: write to a temporary file,
+// fsync, rename and fsync the directory. The edits are applied to what the
+// file holds at commit time, and nothing is written if the result is
+// byte-identical to it. A file that exists but can't be read fails the commit.
+// Commits run on a worker thread, one at a time, so the event loop never
+// waits for the disk.
+class FileCommitter : public QObject
+{
+    Q_OBJECT
+public:
+    // Called on the event loop once the file has been committed or failed to
+    using Callback = std::function<void(bool ok)>;
+    // Turns the current contents into the new ones, nullopt meaning no file.
+    // Runs on the worker thread.
+    using Edit = std::function<std::optional<QByteArray>(const std::optional<QByteArray>& current)>;
+
+    explicit FileCommitter(std::chrono::milliseconds window, QObject* parent = nullptr);
+    // Waits for the commits in progress. Callbacks that did not run by then
+    // are dropped.
+    ~FileCommitter();
+
+    void Update(const QString& path, Edit edit, Callback done);
+    void Write(const QString& path, const QByteArray& contents, Callback done);
+    void Remove(const QString& path, Callback done);
+
+    // Whether edits to path are still waiting for the window or being committed
+    bool IsPending(const QString& path) const;
+
+    // Starts committing everything pending right away
+    void Flush();
+
+private:
+    struct Pending
+    {
+        QList<Edit> edits;
+        QList<Callback> callbacks;
+    };
+
+    void onCommitted(const QString& path, bool ok, const QList<Callback>& callbacks);
+    static bool commit(const QString& path, const QList<Edit>& edits);
+
+    QTimer m_timer;
+    QHash<QString, Pending> m_pending;
+    // path -> number of commits handed to the worker
+    QHash<QString, int> m_committing;
+    QThreadPool m_pool;
+};
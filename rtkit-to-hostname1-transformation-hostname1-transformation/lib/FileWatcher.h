@@ -0,0 +1,33 @@
+/*
+ * Copyright (c) 2026 FreeBSD Foundation
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <memory>
+
+#include <QObject>
+
+// Reports changes to individual files, including the file being created,
+// removed or atomically replaced by a rename. Runs on the Qt event loop, with
+// inotify on Linux and kqueue on FreeBSD.
+class FileWatcher : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FileWatcher(QObject* parent = nullptr);
+    ~FileWatcher();
+
+    bool Watch(const QString& path);
+
+Q_SIGNALS:
+    // Emitted at most once per path for every batch of kernel events
+    void Changed(const QString& path);
+
+private:
+    void readEvents();
+
+    struct Private;
+    std::unique_ptr<Private> d;
+};
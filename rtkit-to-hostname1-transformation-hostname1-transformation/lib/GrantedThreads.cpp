@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2026 FreeBSD Foundation
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "GrantedThreads.h"
+
+void GrantedThreads::Insert(const std::shared_ptr<Process>& process, qulonglong thread,
+                            PriorityType type, qlonglong value)
+{
+    // a pid can only belong to one live process, an older entry is stale.
+    // Drop it before taking a reference, removal may move other entries.
+    auto previous = m_startTimes.constFind(process->Pid());
+    if (previous != m_startTimes.cend() && *previous != process->StartTime())
+        m_processes.remove({process->Pid(), *previous});
+
+    auto& entry = m_processes[key(*process)];
+    if (!entry.process) {
+        m_startTimes.insert(process->Pid(), process->StartTime());
+        entry.process = process;
+    }
+    entry.threads.insert(thread, {type, value});
+}
+
+bool GrantedThreads::Contains(const Process& process) const
+{
+    return m_processes.contains(key(process));
+}
+
+const Process* GrantedThreads::FindPid(pid_t pid) const
+{
+    auto startTime = m_startTimes.constFind(pid);
+    if (startTime == m_startTimes.cend())
+        return nullptr;
+
+    auto it = m_processes.constFind({pid, *startTime});
+    if (it == m_processes.cend())
+        return nullptr;
+    return it->process.get();
+}
+
+void GrantedThreads::RemovePid(pid_t pid)
+{
+    auto it = m_startTimes.find(pid);
+    if (it == m_startTimes.end())
+        return;
+
+    m_processes.remove({pid, *it});
+    m_startTimes.erase(it);
+}
+
+QList<GrantedThreads::Entry> GrantedThreads::TakeAll()
+{
+    QList<Entry> entries;
+    entries.reserve(m_processes.size());
+    for (const auto& entry : std::as_const(m_processes))
+        entries.append(entry);
+
+    m_processes.clear();
+    m_startTimes.clear();
+    return entries;
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2026 FreeBSD Foundation
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <memory>
+
+#include <sys/types.h>
+
+#include <QHash>
+
+#include "Process.h"
+
+enum class PriorityType
+{
+    High,
+    Realtime,
+    Idle
+};
+
+// Threads the daemon has changed the priority of, indexed by the identity of
+// their process, i.e. its pid and start time. Asking again for the same thread
+// overwrites the previous grant instead of adding another entry.
+class GrantedThreads
+{
+public:
+    struct Grant
+    {
+        PriorityType type;
+        qlonglong value;
+    };
+
+    // Keyed by thread id
+    using Threads = QHash<qulonglong, Grant>;
+
+    struct Entry
+    {
+        std::shared_ptr<Process> process;
+        Threads threads;
+    };
+
+    void Insert(const std::shared_ptr<Process>& process, qulonglong thread,
+                PriorityType type, qlonglong value);
+    bool Contains(const Process& process) const;
+    const Process* FindPid(pid_t pid) const;
+    // For when only the pid is known, like on process exit
+    void RemovePid(pid_t pid);
+    // Empties the registry, handing out what it held
+    QList<Entry> TakeAll();
+
+    qsizetype ProcessCount() const { return m_processes.size(); }
+
+private:
+    struct Key
+    {
+        pid_t pid;
+        qulonglong startTime;
+
+        bool operator==(const Key&) const = default;
+    };
+    friend size_t qHash(const Key& key, size_t seed)
+    {
+        return qHashMulti(seed, key.pid, key.startTime);
+    }
+
+    static Key key(const Process& process)
+    {
+        return {process.Pid(), process.StartTime()};
+    }
+
+    QHash<Key, Entry> m_processes;
+    // pid -> start time of the entry with that pid
+    QHash<pid_t, qulonglong> m_startTimes;
+};
@@ -0,0 +1,958 @@
+/*
+ * Copyright (c) 2026 FreeBSD Foundation
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <QDBusMetaType>
+#include <QDate>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTimeZone>
+
+#include <unistd.h>
+#include <sys/utsname.h>
+
+#include <AuthQueue>
+#include <CredentialsCache.h>
+#include <DBusSavedContext>
+
+#include "FileWatcher.h"
+#include "Hostnamed.h"
+#include "Probes.h"
+
+#include "Hostname1Adaptor.h"
+#include "Hostname1StatsAdaptor.h"
+
+static const QString Hostname1Service = QStringLiteral("org.freedesktop.hostname1");
+static const QString Hostname1Interface = QStringLiteral("org.freedesktop.hostname1");
+static const QString Hostname1ObjectPath = QStringLiteral("/org/freedesktop/hostname1");
+
+static const QString SetHostnameAction = QStringLiteral("org.freedesktop.hostname1.set-hostname");
+static const QString SetStaticHostnameAction = QStringLiteral("org.freedesktop.hostname1.set-static-hostname");
+static const QString SetMachineInfoAction = QStringLiteral("org.freedesktop.hostname1.set-machine-info");
+
+// Every setter rewrites a file and wakes all subscribers, so keep a single
+// user from doing that in a loop. Root is not limited.
+static constexpr RateLimiter::Policy SetterRate{0.5, 10};
+
+static const QString StaticHostnamePath = QStringLiteral("/etc/hostname");
+static const QString MachineInfoPath = QStringLiteral("/etc/machine-info");
+static const QStringList OSReleasePaths = {
+    QStringLiteral("/etc/os-release"),
+    QStringLiteral("/usr/lib/os-release"),
+    QStringLiteral("/var/run/os-release"),
+};
+static const QStringList MachineIDPaths = {
+    QStringLiteral("/etc/machine-id"),
+    QStringLiteral("/var/lib/dbus/machine-id"),
+    QStringLiteral("/var/db/dbus/machine-id"),
+};
+
+static const QStringList ValidChassis = {
+    QStringLiteral("desktop"),
+    QStringLiteral("laptop"),
+    QStringLiteral("convertible"),
+    QStringLiteral("server"),
+    QStringLiteral("tablet"),
+    QStringLiteral("handset"),
+    QStringLiteral("watch"),
+    QStringLiteral("embedded"),
+    QStringLiteral("vm"),
+    QStringLiteral("container"),
+};
+
+// Properties that can change at runtime, which is everything Describe() has to
+// render on top of the const ones
+static const QStringList MutableProperties = {
+    QStringLiteral("Hostname"),
+    QStringLiteral("StaticHostname"),
+    QStringLiteral("PrettyHostname"),
+    QStringLiteral("HostnameSource"),
+    QStringLiteral("IconName"),
+    QStringLiteral("Chassis"),
+    QStringLiteral("Deployment"),
+    QStringLiteral("Location"),
+};
+
+// Properties backed by machine-info(5)
+static const QStringList MachineInfoProperties = {
+    QStringLiteral("PrettyHostname"),
+    QStringLiteral("IconName"),
+    QStringLiteral("Chassis"),
+    QStringLiteral("Deployment"),
+    QStringLiteral("Location"),
+};
+
+// machine-info(5) keys of the properties SetMachineInfo() accepts
+static const QHash<QString, QString> MachineInfoKeys = {
+    {QStringLiteral("PrettyHostname"), QStringLiteral("PRETTY_HOSTNAME")},
+    {QStringLiteral("IconName"), QStringLiteral("ICON_NAME")},
+    {QStringLiteral("Chassis"), QStringLiteral("CHASSIS")},
+    {QStringLiteral("Deployment"), QStringLiteral("DEPLOYMENT")},
+    {QStringLiteral("Location"), QStringLiteral("LOCATION")},
+};
+
+// How long edits to a file are collected before it is written
+static constexpr std::chrono::milliseconds CommitWindow{20};
+
+// How long property changes are collected before being announced
+static constexpr std::chrono::milliseconds PropertiesChangedDelay{50};
+
+// Same limit as systemd-hostnamed, regardless of what the kernel allows
+static constexpr qsizetype MaxHostnameLength = 64;
+
+namespace
+{
+
+bool IsValidHostname(const QString& hostname)
+{
+    if (hostname.isEmpty() || hostname.size() > MaxHostnameLength)
+        return false;
+
+    for (const auto& label : QStringView(hostname).split(u'.')) {
+        if (label.isEmpty() || label.size() > 63)
+            return false;
+        if (label.startsWith(u'-') || label.endsWith(u'-'))
+            return false;
+        for (QChar c : label)
+            if (c.unicode() > 127 || (!c.isLetterOrNumber() && c != u'-'))
+                return false;
+    }
+
+    return true;
+}
+
+bool IsValidMachineInfoValue(const QString& value)
+{
+    for (QChar c : value)
+        if (c.category() == QChar::Other_Control)
+            return false;
+    return value.size() <= 255;
+}
+
+bool IsValidIconName(const QString& icon)
+{
+    for (QChar c : icon)
+        if (c.unicode() > 127 || (!c.isLetterOrNumber() && c != u'-' && c != u'_' && c != u'.'))
+            return false;
+    return icon.size() <= 255 && !icon.startsWith(u'.');
+}
+
+// Same checks as the individual setters
+bool IsValidMachineInfoField(const QString& property, const QString& value)
+{
+    if (property == QLatin1String("IconName"))
+        return IsValidIconName(value);
+    if (property == QLatin1String("Chassis"))
+        return value.isEmpty() || ValidChassis.contains(value);
+    if (property == QLatin1String("Deployment"))
+        return IsValidMachineInfoValue(value) && !value.contains(u' ');
+    return IsValidMachineInfoValue(value);
+}
+
+qulonglong DateToUSec(const QDate& date)
+{
+    if (!date.isValid())
+        return 0;
+    return date.startOfDay(QTimeZone::utc()).toMSecsSinceEpoch() * 1000;
+}
+
+// Renders the members of a JSON object, without the enclosing braces
+QByteArray RenderJsonMembers(const QVariantMap& values)
+{
+    QByteArray json = QJsonDocument(QJsonObject::fromVariantMap(values)).toJson(QJsonDocument::Compact);
+    return json.sliced(1, json.size() - 2);
+}
+
+QString ReadFirstLine(const QStringList& paths)
+{
+    for (const auto& path : paths) {
+        QFile file(path);
+        if (file.open(QIODevice::ReadOnly))
+            return QString::fromUtf8(file.readLine().trimmed());
+    }
+    return {};
+}
+
+// An empty value removes the key
+void ApplyMachineInfoChanges(EnvFile::Values& values, const EnvFile::Values& changes)
+{
+    for (auto it = changes.cbegin(); it != changes.cend(); ++it) {
+        if (it.value().isEmpty())
+            values.remove(it.key());
+        else
+            values.insert(it.key(), it.value());
+    }
+}
+
+}
+
+Hostnamed::Hostnamed(const QDBusConnection& bus)
+    : m_bus(bus)
+    , m_committer(CommitWindow)
+{
+    m_propertiesChangedTimer.setSingleShot(true);
+    m_propertiesChangedTimer.setInterval(PropertiesChangedDelay);
+    connect(&m_propertiesChangedTimer, &QTimer::timeout, this, &Hostnamed::flushPropertiesChanged);
+
+    m_rateLimiter.SetPolicy(SetHostnameAction, SetterRate);
+    m_rateLimiter.SetPolicy(SetStaticHostnameAction, SetterRate);
+    m_rateLimiter.SetPolicy(SetMachineInfoAction, SetterRate);
+
+    qDBusRegisterMetaType<QMap<QString, QString>>();
+}
+
+Hostnamed::~Hostnamed()
+{
+}
+
+bool Hostnamed::Start()
+{
+    new Hostname1Adaptor(this);
+    new Hostname1StatsAdaptor(this);
+    CallStats::getInstance()->Register(&Hostname1Adaptor::staticMetaObject);
+
+    m_const = readConstProperties();
+    m_describeConstMembers = RenderJsonMembers(constPropertyValues(m_const));
+
+    m_staticHostname = ReadFirstLine({StaticHostnamePath});
+    m_machineInfo = EnvFile::Read(MachineInfoPath);
+    watchFiles();
+
+    if(!m_bus.registerObject(Hostname1ObjectPath, this)) {
+        qCritical() << "Could not register" << Hostname1ObjectPath << "object";
+        return false;
+    }
+
+    if(!m_bus.registerService(Hostname1Service)) {
+        qCritical() << "Could not register" << Hostname1Service << "service";
+        return false;
+    }
+
+    return true;
+}
+
+Hostnamed::ConstProperties Hostnamed::readConstProperties()
+{
+    ConstProperties props;
+
+    struct utsname uts;
+    if (uname(&uts) == 0) {
+        props.kernelName = QString::fromUtf8(uts.sysname);
+        props.kernelRelease = QString::fromUtf8(uts.release);
+        props.kernelVersion = QString::fromUtf8(uts.version).trimmed();
+    }
+
+    readOSRelease(props);
+
+    props.hardware = SystemInfo::ReadHardware();
+    props.firmwareDate = DateToUSec(QDate::fromString(props.hardware.firmwareDate, QStringLiteral("MM/dd/yyyy")));
+
+    props.machineID = ReadFirstLine(MachineIDPaths);
+    props.bootID = SystemInfo::ReadBootID();
+    props.vsockCID = SystemInfo::ReadVSockCID();
+
+    return props;
+}
+
+void Hostnamed::readOSRelease(ConstProperties& props)
+{
+    EnvFile::Values osRelease;
+    for (const auto& path : OSReleasePaths) {
+        osRelease = EnvFile::Read(path);
+        if (!osRelease.isEmpty())
+            break;
+    }
+
+    props.defaultHostname = osRelease.value(QStringLiteral("DEFAULT_HOSTNAME"));
+    if (!IsValidHostname(props.defaultHostname))
+        props.defaultHostname = QStringLiteral("localhost");
+    props.osPrettyName = osRelease.value(QStringLiteral("PRETTY_NAME"));
+    props.osCPEName = osRelease.value(QStringLiteral("CPE_NAME"));
+    props.osSupportEnd = DateToUSec(QDate::fromString(osRelease.value(QStringLiteral("SUPPORT_END")), Qt::ISODate));
+    props.homeURL = osRelease.value(QStringLiteral("HOME_URL"));
+}
+
+QVariantMap Hostnamed::constPropertyValues(const ConstProperties& props)
+{
+    return {
+        {QStringLiteral("DefaultHostname"), props.defaultHostname},
+        {QStringLiteral("KernelName"), props.kernelName},
+        {QStringLiteral("KernelRelease"), props.kernelRelease},
+        {QStringLiteral("KernelVersion"), props.kernelVersion},
+        {QStringLiteral("OperatingSystemPrettyName"), props.osPrettyName},
+        {QStringLiteral("OperatingSystemCPEName"), props.osCPEName},
+        {QStringLiteral("OperatingSystemSupportEnd"), props.osSupportEnd},
+        {QStringLiteral("HomeURL"), props.homeURL},
+        {QStringLiteral("HardwareVendor"), props.hardware.vendor},
+        {QStringLiteral("HardwareModel"), props.hardware.model},
+        {QStringLiteral("FirmwareVersion"), props.hardware.firmwareVersion},
+        {QStringLiteral("FirmwareVendor"), props.hardware.firmwareVendor},
+        {QStringLiteral("FirmwareDate"), props.firmwareDate},
+        {QStringLiteral("MachineID"), props.machineID},
+        {QStringLiteral("BootID"), props.bootID},
+        {QStringLiteral("VSockCID"), props.vsockCID},
+    };
+}
+
+QString Hostnamed::Hostname() const
+{
+    PROBE(PROPERTY_READ, "Hostname");
+    char buf[256];
+    if (gethostname(buf, sizeof(buf)) != 0)
+        return {};
+    buf[sizeof(buf) - 1] = '\0';
+    return QString::fromUtf8(buf);
+}
+
+QString Hostnamed::StaticHostname() const
+{
+    PROBE(PROPERTY_READ, "StaticHostname");
+    return m_staticHostname;
+}
+
+QString Hostnamed::PrettyHostname() const
+{
+    PROBE(PROPERTY_READ, "PrettyHostname");
+    return readMachineInfo(QStringLiteral("PRETTY_HOSTNAME"));
+}
+
+QString Hostnamed::DefaultHostname() const
+{
+    PROBE(PROPERTY_READ, "DefaultHostname");
+    return m_const.defaultHostname;
+}
+
+QString Hostnamed::HostnameSource() const
+{
+    PROBE(PROPERTY_READ, "HostnameSource");
+    auto hostname = Hostname();
+    auto staticHostname = StaticHostname();
+
+    if (!staticHostname.isEmpty() && hostname == staticHostname)
+        return QStringLiteral("static");
+    if (staticHostname.isEmpty() && hostname == m_const.defaultHostname)
+        return QStringLiteral("default");
+    return QStringLiteral("transient");
+}
+
+QString Hostnamed::IconName() const
+{
+    PROBE(PROPERTY_READ, "IconName");
+    auto icon = readMachineInfo(QStringLiteral("ICON_NAME"));
+    if (!icon.isEmpty())
+        return icon;
+
+    auto chassis = Chassis();
+    if (chassis.isEmpty())
+        return QStringLiteral("computer");
+    return QStringLiteral("computer-") + chassis;
+}
+
+QString Hostnamed::Chassis() const
+{
+    PROBE(PROPERTY_READ, "Chassis");
+    auto chassis = readMachineInfo(QStringLiteral("CHASSIS"));
+    if (!chassis.isEmpty())
+        return chassis;
+    return m_const.hardware.chassis;
+}
+
+QString Hostnamed::Deployment() const
+{
+    PROBE(PROPERTY_READ, "Deployment");
+    return readMachineInfo(QStringLiteral("DEPLOYMENT"));
+}
+
+QString Hostnamed::Location() const
+{
+    PROBE(PROPERTY_READ, "Location");
+    return readMachineInfo(QStringLiteral("LOCATION"));
+}
+
+QString Hostnamed::KernelName() const
+{
+    PROBE(PROPERTY_READ, "KernelName");
+    return m_const.kernelName;
+}
+
+QString Hostnamed::KernelRelease() const
+{
+    PROBE(PROPERTY_READ, "KernelRelease");
+    return m_const.kernelRelease;
+}
+
+QString Hostnamed::KernelVersion() const
+{
+    PROBE(PROPERTY_READ, "KernelVersion");
+    return m_const.kernelVersion;
+}
+
+QString Hostnamed::OperatingSystemPrettyName() const
+{
+    PROBE(PROPERTY_READ, "OperatingSystemPrettyName");
+    return m_const.osPrettyName;
+}
+
+QString Hostnamed::OperatingSystemCPEName() const
+{
+    PROBE(PROPERTY_READ, "OperatingSystemCPEName");
+    return m_const.osCPEName;
+}
+
+qulonglong Hostnamed::OperatingSystemSupportEnd() const
+{
+    PROBE(PROPERTY_READ, "OperatingSystemSupportEnd");
+    return m_const.osSupportEnd;
+}
+
+QString Hostnamed::HomeURL() const
+{
+    PROBE(PROPERTY_READ, "HomeURL");
+    return m_const.homeURL;
+}
+
+QString Hostnamed::HardwareVendor() const
+{
+    PROBE(PROPERTY_READ, "HardwareVendor");
+    return m_const.hardware.vendor;
+}
+
+QString Hostnamed::HardwareModel() const
+{
+    PROBE(PROPERTY_READ, "HardwareModel");
+    return m_const.hardware.model;
+}
+
+QString Hostnamed::FirmwareVersion() const
+{
+    PROBE(PROPERTY_READ, "FirmwareVersion");
+    return m_const.hardware.firmwareVersion;
+}
+
+QString Hostnamed::FirmwareVendor() const
+{
+    PROBE(PROPERTY_READ, "FirmwareVendor");
+    return m_const.hardware.firmwareVendor;
+}
+
+qulonglong Hostnamed::FirmwareDate() const
+{
+    PROBE(PROPERTY_READ, "FirmwareDate");
+    return m_const.firmwareDate;
+}
+
+QString Hostnamed::MachineID() const
+{
+    PROBE(PROPERTY_READ, "MachineID");
+    return m_const.machineID;
+}
+
+QString Hostnamed::BootID() const
+{
+    PROBE(PROPERTY_READ, "BootID");
+    return m_const.bootID;
+}
+
+qulonglong Hostnamed::VSockCID() const
+{
+    PROBE(PROPERTY_READ, "VSockCID");
+    return m_const.vsockCID;
+}
+
+QVariantMap Hostnamed::MethodCalls() const
+{
+    return CallStats::getInstance()->ToVariant();
+}
+
+uint Hostnamed::AuthQueueDepth() const
+{
+    return AuthQueue::getInstance()->QueueDepth();
+}
+
+uint Hostnamed::AuthQueueInFlight() const
+{
+    return AuthQueue::getInstance()->InFlight();
+}
+
+QVariantMap Hostnamed::PolkitWait() const
+{
+    return AuthQueue::getInstance()->PolkitWait().ToVariant();
+}
+
+qulonglong Hostnamed::RateLimitRejections() const
+{
+    return m_rateLimiter.Rejected();
+}
+
+// The interactive arguments of the methods below are not consulted: whether
+// polkit may interact with the user is decided by the message flags, see
+// AuthQueue::dispatchItem()
+
+void Hostnamed::SetHostname(const QString& hostname, bool interactive)
+{
+    CallTimer timer(this);
+    Q_UNUSED(interactive);
+    auto* context = this;
+
+    QString newHostname = hostname;
+    if (newHostname.isEmpty())
+        newHostname = StaticHostname();
+    if (newHostname.isEmpty())
+        newHostname = m_const.defaultHostname;
+
+    if (!IsValidHostname(newHostname))
+        DBUS_THROW_CONTEXT_VOID("org.freedesktop.DBus.Error.InvalidArgs", "Invalid hostname");
+
+    if (newHostname == Hostname())
+        return;
+
+    authorizeSetter(SetHostnameAction, [=, this](auto r, auto* context)
+    {
+        if (r != PolkitQt1::Authority::Result::Yes)
+            DBUS_THROW_CONTEXT_VOID("org.freedesktop.DBus.Error.AccessDenied", "You are not allowed to set the hostname");
+
+        QByteArray name = newHostname.toUtf8();
+        if (sethostname(name.constData(), name.size()) != 0)
+            DBUS_THROW_CONTEXT_VOID("org.freedesktop.DBus.Error.Failed", "Failed to set hostname");
+        PROBE(PROPERTY_WRITE, "Hostname", name.constData());
+
+        emitPropertiesChanged({QStringLiteral("Hostname"), QStringLiteral("HostnameSource")});
+
+        context->sendReply();
+    });
+}
+
+void Hostnamed::SetStaticHostname(const QString& hostname, bool interactive)
+{
+    CallTimer timer(this);
+    Q_UNUSED(interactive);
+    auto* context = this;
+
+    if (!hostname.isEmpty() && !IsValidHostname(hostname))
+        DBUS_THROW_CONTEXT_VOID("org.freedesktop.DBus.Error.InvalidArgs", "Invalid static hostname");
+
+    if (hostname == m_staticHostname)
+        return;
+
+    authorizeSetter(SetStaticHostnameAction, [=, this](auto r, auto* context)
+    {
+        if (r != PolkitQt1::Authority::Result::Yes)
+            DBUS_THROW_CONTEXT_VOID("org.freedesktop.DBus.Error.AccessDenied", "You are not allowed to set the static hostname");
+
+        // visible right away, so that edits made within the commit window
+        // build on each other
+        m_staticHostname = hostname;
+
+        DBusSavedContext saved(*context);
+        auto committed = [=, this](bool ok)
+        {
+            auto* context = &saved;
+
+            if (!ok) {
+                onFileChanged(StaticHostnamePath);
+                DBUS_THROW_CONTEXT_VOID("org.freedesktop.DBus.Error.Failed", "Failed to write static hostname");
+            }
+
+            // the static hostname takes effect right away
+            QByteArray name = (hostname.isEmpty() ? m_const.defaultHostname : hostname).toUtf8();
+            if (sethostname(name.constData(), name.size()) != 0)
+                qWarning() << "Failed to apply static hostname" << name;
+            PROBE(PROPERTY_WRITE, "StaticHostname", qUtf8Printable(hostname));
+
+            emitPropertiesChanged({QStringLiteral("StaticHostname"),
+                                   QStringLiteral("Hostname"),
+                                   QStringLiteral("HostnameSource")});
+
+            saved.sendReply();
+        };
+
+        if (hostname.isEmpty())
+            m_committer.Remove(StaticHostnamePath, committed);
+        else
+            m_committer.Write(StaticHostnamePath, hostname.toUtf8() + '\n', committed);
+    });
+}
+
+void Hostnamed::SetPrettyHostname(const QString& hostname, bool interactive)
+{
+    CallTimer timer(this);
+    Q_UNUSED(interactive);
+    auto* context = this;
+
+    if (!IsValidMachineInfoValue(hostname))
+        DBUS_THROW_CONTEXT_VOID("org.freedesktop.DBus.Error.InvalidArgs", "Invalid pretty hostname");
+
+    // same as systemd-hostnamed, the pretty hostname goes with the static one
+    setMachineInfo(QStringLiteral("PRETTY_HOSTNAME"), hostname,
+                   SetStaticHostnameAction,
+                   {QStringLiteral("PrettyHostname")});
+}
+
+void Hostnamed::SetIconName(const QString& icon, bool interactive)
+{
+    CallTimer timer(this);
+    Q_UNUSED(interactive);
+    auto* context = this;
+
+    if (!IsValidIconName(icon))
+        DBUS_THROW_CONTEXT_VOID("org.freedesktop.DBus.Error.InvalidArgs", "Invalid icon name");
+
+    setMachineInfo(QStringLiteral("ICON_NAME"), icon,
+                   SetMachineInfoAction,
+                   {QStringLiteral("IconName")});
+}
+
+void Hostnamed::SetChassis(const QString& chassis, bool interactive)
+{
+    CallTimer timer(this);
+    Q_UNUSED(interactive);
+    auto* context = this;
+
+    if (!chassis.isEmpty() && !ValidChassis.contains(chassis))
+        DBUS_THROW_CONTEXT_VOID("org.freedesktop.DBus.Error.InvalidArgs", "Invalid chassis");
+
+    // the default icon name is derived from the chassis
+    setMachineInfo(QStringLiteral("CHASSIS"), chassis,
+                   SetMachineInfoAction,
+                   {QStringLiteral("Chassis"), QStringLiteral("IconName")});
+}
+
+void Hostnamed::SetDeployment(const QString& deployment, bool interactive)
+{
+    CallTimer timer(this);
+    Q_UNUSED(interactive);
+    auto* context = this;
+
+    if (!IsValidMachineInfoValue(deployment) || deployment.contains(u' '))
+        DBUS_THROW_CONTEXT_VOID("org.freedesktop.DBus.Error.InvalidArgs", "Invalid deployment");
+
+    setMachineInfo(QStringLiteral("DEPLOYMENT"), deployment,
+                   SetMachineInfoAction,
+                   {QStringLiteral("Deployment")});
+}
+
+void Hostnamed::SetLocation(const QString& location, bool interactive)
+{
+    CallTimer timer(this);
+    Q_UNUSED(interactive);
+    auto* context = this;
+
+    if (!IsValidMachineInfoValue(location))
+        DBUS_THROW_CONTEXT_VOID("org.freedesktop.DBus.Error.InvalidArgs", "Invalid location");
+
+    setMachineInfo(QStringLiteral("LOCATION"), location,
+                   SetMachineInfoAction,
+                   {QStringLiteral("Location")});
+}
+
+void Hostnamed::SetMachineInfo(const QMap<QString, QString>& fields, bool interactive)
+{
+    CallTimer timer(this);
+    Q_UNUSED(interactive);
+    auto* context = this;
+
+    EnvFile::Values changes;
+    QStringList changedProperties;
+    for (auto it = fields.cbegin(); it != fields.cend(); ++it) {
+        auto key = MachineInfoKeys.value(it.key());
+        if (key.isEmpty())
+            DBUS_THROW_CONTEXT_VOID("org.freedesktop.DBus.Error.InvalidArgs", "Unknown machine information field");
+        if (!IsValidMachineInfoField(it.key(), it.value()))
+            DBUS_THROW_CONTEXT_VOID("org.freedesktop.DBus.Error.InvalidArgs", "Invalid machine information value");
+
+        if (readMachineInfo(key) == it.value())
+            continue;
+
+        changes.insert(key, it.value());
+        changedProperties << it.key();
+        // the default icon name is derived from the chassis
+        if (it.key() == QLatin1String("Chassis") && !changedProperties.contains(QStringLiteral("IconName")))
+            changedProperties << QStringLiteral("IconName");
+    }
+
+    if (changes.isEmpty())
+        return;
+
+    // lets the polkit agent tell what is about to change
+    PolkitQt1::DetailsMap details{{QStringLiteral("fields"), changedProperties.join(u',')}};
+
+    auto apply = [=, this](auto r, auto* context)
+    {
+        if (r != PolkitQt1::Authority::Result::Yes)
+            DBUS_THROW_CONTEXT_VOID("org.freedesktop.DBus.Error.AccessDenied", "You are not allowed to change machine information");
+
+        commitMachineInfo(*context, changes, changedProperties);
+    };
+
+    // The pretty hostname is guarded by set-static-hostname like in
+    // SetPrettyHostname(). That action is the stricter of the two, so it
+    // covers the other fields as well and the caller is asked only once.
+    const auto& actionId = changes.contains(QStringLiteral("PRETTY_HOSTNAME"))
+        ? SetStaticHostnameAction : SetMachineInfoAction;
+    authorizeSetter(actionId, apply, details);
+}
+
+QByteArray Hostnamed::GetProductUUID(bool interactive)
+{
+    CallTimer timer(this);
+    Q_UNUSED(interactive);
+    auto* context = this;
+
+    if (m_const.hardware.productUUID.isEmpty())
+        DBUS_THROW_CONTEXT("org.freedesktop.hostname1.NoProductUUID", "Failed to read product UUID");
+
+    AuthQueue::getInstance()->Enqueue(QStringLiteral("org.freedesktop.hostname1.get-product-uuid"),
+                                      context, {},
+                                      [uuid = m_const.hardware.productUUID](auto r, auto* context)
+    {
+        if (r != PolkitQt1::Authority::Result::Yes)
+            DBUS_THROW_CONTEXT_VOID("org.freedesktop.DBus.Error.AccessDenied", "You are not allowed to get the product UUID");
+
+        context->sendReply(QVariant(uuid));
+    });
+
+    return {};
+}
+
+QString Hostnamed::GetHardwareSerial()
+{
+    CallTimer timer(this);
+    auto* context = this;
+
+    if (m_const.hardware.serial.isEmpty())
+        DBUS_THROW_CONTEXT("org.freedesktop.DBus.Error.Failed", "Failed to read hardware serial");
+
+    AuthQueue::getInstance()->Enqueue(QStringLiteral("org.freedesktop.hostname1.get-hardware-serial"),
+                                      context, {},
+                                      [serial = m_const.hardware.serial](auto r, auto* context)
+    {
+        if (r != PolkitQt1::Authority::Result::Yes)
+            DBUS_THROW_CONTEXT_VOID("org.freedesktop.DBus.Error.AccessDenied", "You are not allowed to get the hardware serial");
+
+        context->sendReply(QVariant(serial));
+    });
+
+    return {};
+}
+
+QString Hostnamed::Describe()
+{
+    CallTimer timer(this);
+    refreshDescribe();
+
+    if (!m_describe.isNull())
+        return m_describe;
+
+    QByteArray json = '{' + m_describeConstMembers;
+    for (const auto& name : MutableProperties) {
+        auto& member = m_describeMembers[name];
+        if (member.isNull())
+            member = RenderJsonMembers({{name, property(name.toLatin1().constData())}});
+        json += ',' + member;
+    }
+    json += '}';
+
+    m_describe = QString::fromUtf8(json);
+    return m_describe;
+}
+
+// Everything else is announced through emitPropertiesChanged(), but nothing
+// tells when the transient hostname is changed behind our back
+void Hostnamed::refreshDescribe()
+{
+    auto hostname = Hostname();
+    if (hostname != m_describeHostname) {
+        m_describeHostname = hostname;
+        invalidateDescribe({QStringLiteral("Hostname"), QStringLiteral("HostnameSource")});
+    }
+}
+
+void Hostnamed::invalidateDescribe(const QStringList& properties)
+{
+    for (const auto& name : properties)
+        m_describeMembers.remove(name);
+    m_describe = QString();
+}
+
+void Hostnamed::authorizeSetter(const QString& actionId,
+                                AuthQueue::Continuation continuation,
+                                const PolkitQt1::DetailsMap& details)
+{
+    DBusSavedContext saved(this);
+
+    CredentialsCache::getInstance()->Lookup(connection(), message().service(),
+                                            [=, this](const Credentials& caller)
+    {
+        auto* context = &saved;
+
+        if (!caller.isValid())
+            DBUS_RETHROW_CONTEXT_VOID(caller);
+
+        if (caller.uid != 0 && !m_rateLimiter.Acquire(actionId, caller.uid))
+            DBUS_THROW_CONTEXT_VOID("org.freedesktop.DBus.Error.AccessDenied", "You are calling too often");
+
+        AuthQueue::getInstance()->EnqueueWithDetails(actionId, details, saved, {}, continuation);
+    });
+}
+
+QString Hostnamed::readMachineInfo(const QString& key) const
+{
+    return m_machineInfo.value(key);
+}
+
+void Hostnamed::setMachineInfo(const QString& key,
+                               const QString& value,
+                               const QString& actionId,
+                               const QStringList& changedProperties)
+{
+    if (readMachineInfo(key) == value)
+        return;
+
+    authorizeSetter(actionId, [=, this](auto r, auto* context)
+    {
+        if (r != PolkitQt1::Authority::Result::Yes)
+            DBUS_THROW_CONTEXT_VOID("org.freedesktop.DBus.Error.AccessDenied", "You are not allowed to change machine information");
+
+        commitMachineInfo(*context, {{key, value}}, changedProperties);
+    });
+}
+
+// Applies the changes to m_machineInfo and queues them for writing, replying
+// once they are on disk. Setters called within the commit window all end up in
+// the same write. The changes are made to the file as it is at commit time, so
+// fields edited by someone else meanwhile are kept.
+void Hostnamed::commitMachineInfo(const DBusSavedContext& context,
+                                  const EnvFile::Values& changes,
+                                  const QStringList& changedProperties)
+{
+    ApplyMachineInfoChanges(m_machineInfo, changes);
+    m_unsavedMachineInfo.insert(changes);
+
+    DBusSavedContext saved(context);
+    auto committed = [=, this](bool ok)
+    {
+        auto* context = &saved;
+
+        // everything handed over so far has been committed or failed to
+        if (!m_committer.IsPending(MachineInfoPath))
+            m_unsavedMachineInfo.clear();
+
+        if (!ok) {
+            onFileChanged(MachineInfoPath);
+            DBUS_THROW_CONTEXT_VOID("org.freedesktop.DBus.Error.Failed", "Failed to write machine information");
+        }
+
+        for (const auto& name : changedProperties)
+            PROBE(PROPERTY_WRITE, qUtf8Printable(name), qUtf8Printable(property(name.toLatin1()).toString()));
+        emitPropertiesChanged(changedProperties);
+
+        saved.sendReply();
+    };
+
+    auto edit = [changes](const std::optional<QByteArray>& current) -> std::optional<QByteArray>
+    {
+        auto values = current ? EnvFile::Parse(*current) : EnvFile::Values();
+        ApplyMachineInfoChanges(values, changes);
+        if (values.isEmpty())
+            return std::nullopt;
+        return EnvFile::Serialize(values);
+    };
+    m_committer.Update(MachineInfoPath, edit, committed);
+}
+
+// Changes are not announced right away but collected for PropertiesChangedDelay,
+// so that a client calling several setters in a row wakes every subscriber
+// once. Values are read when the signal is finally sent.
+void Hostnamed::emitPropertiesChanged(const QStringList& properties)
+{
+    invalidateDescribe(properties);
+
+    for (const auto& name : properties)
+        if (!m_pendingChanges.contains(name))
+            m_pendingChanges << name;
+
+    if (!m_propertiesChangedTimer.isActive())
+        m_propertiesChangedTimer.start();
+}
+
+void Hostnamed::flushPropertiesChanged()
+{
+    QVariantMap changed;
+    for (const auto& name : std::as_const(m_pendingChanges))
+        changed.insert(name, property(name.toLatin1().constData()));
+    m_pendingChanges.clear();
+
+    if (changed.isEmpty())
+        return;
+
+    auto signal = QDBusMessage::createSignal(Hostname1ObjectPath,
+                                             QStringLiteral("org.freedesktop.DBus.Properties"),
+                                             QStringLiteral("PropertiesChanged"));
+    signal << Hostname1Interface << changed << QStringList();
+    m_bus.send(signal);
+}
+
+void Hostnamed::watchFiles()
+{
+    m_watcher = new FileWatcher(this);
+    connect(m_watcher, &FileWatcher::Changed, this, &Hostnamed::onFileChanged);
+
+    QStringList paths = {StaticHostnamePath, MachineInfoPath};
+    for (const auto& path : OSReleasePaths) {
+        paths << path;
+        // /etc/os-release is usually a symlink, changes happen to its target
+        QString target = QFileInfo(path).canonicalFilePath();
+        if (!target.isEmpty() && target != path)
+            paths << target;
+    }
+
+    for (const auto& path : paths)
+        if (!m_watcher->Watch(path))
+            qWarning() << "Could not watch" << path << "for changes";
+}
+
+// Re-reads the file that changed and announces the properties whose values
+// actually differ. Our own writes end up here too, but by then the cached
+// values are already up to date and nothing is emitted twice.
+void Hostnamed::onFileChanged(const QString& path)
+{
+    const auto before = mutablePropertyValues();
+
+    if (path == StaticHostnamePath) {
+        // a single value, which the pending write is going to replace
+        if (!m_committer.IsPending(path))
+            m_staticHostname = ReadFirstLine({StaticHostnamePath});
+    } else if (path == MachineInfoPath) {
+        // the changes that are not on disk yet go on top of the file
+        m_machineInfo = EnvFile::Read(MachineInfoPath);
+        ApplyMachineInfoChanges(m_machineInfo, m_unsavedMachineInfo);
+    } else {
+        // os-release, affects DefaultHostname and thus HostnameSource
+        ConstProperties props = m_const;
+        readOSRelease(props);
+        m_const = props;
+        m_describeConstMembers = RenderJsonMembers(constPropertyValues(m_const));
+        m_describe = QString();
+    }
+
+    const auto after = mutablePropertyValues();
+
+    QStringList changed;
+    for (auto it = after.cbegin(); it != after.cend(); ++it)
+        if (it.value() != before.value(it.key()))
+            changed << it.key();
+
+    if (!changed.isEmpty())
+        emitPropertiesChanged(changed);
+}
+
+QVariantMap Hostnamed::mutablePropertyValues() const
+{
+    QVariantMap values;
+    for (const auto& name : MutableProperties)
+        values.insert(name, property(name.toLatin1().constData()));
+    return values;
+}
@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) 2026 FreeBSD Foundation
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <QDBusConnection>
+#include <QDBusContext>
+#include <QHash>
+#include <QMap>
+#include <QTimer>
+#include <QVariantMap>
+
+#include <AuthQueue>
+#include <DBusSavedContext>
+
+#include "EnvFile.h"
+#include "FileCommitter.h"
+#include "RateLimiter.h"
+#include "SystemInfo.h"
+
+class FileWatcher;
+
+class Hostnamed : public QObject,
+                  protected QDBusContext
+{
+    Q_OBJECT
+public:
+    Hostnamed(const QDBusConnection& bus);
+    ~Hostnamed();
+
+    bool Start();
+
+public:
+    Q_PROPERTY(QString Hostname READ Hostname)
+    QString Hostname() const;
+
+    Q_PROPERTY(QString StaticHostname READ StaticHostname)
+    QString StaticHostname() const;
+
+    Q_PROPERTY(QString PrettyHostname READ PrettyHostname)
+    QString PrettyHostname() const;
+
+    Q_PROPERTY(QString DefaultHostname READ DefaultHostname)
+    QString DefaultHostname() const;
+
+    Q_PROPERTY(QString HostnameSource READ HostnameSource)
+    QString HostnameSource() const;
+
+    Q_PROPERTY(QString IconName READ IconName)
+    QString IconName() const;
+
+    Q_PROPERTY(QString Chassis READ Chassis)
+    QString Chassis() const;
+
+    Q_PROPERTY(QString Deployment READ Deployment)
+    QString Deployment() const;
+
+    Q_PROPERTY(QString Location READ Location)
+    QString Location() const;
+
+    Q_PROPERTY(QString KernelName READ KernelName)
+    QString KernelName() const;
+
+    Q_PROPERTY(QString KernelRelease READ KernelRelease)
+    QString KernelRelease() const;
+
+    Q_PROPERTY(QString KernelVersion READ KernelVersion)
+    QString KernelVersion() const;
+
+    Q_PROPERTY(QString OperatingSystemPrettyName READ OperatingSystemPrettyName)
+    QString OperatingSystemPrettyName() const;
+
+    Q_PROPERTY(QString OperatingSystemCPEName READ OperatingSystemCPEName)
+    QString OperatingSystemCPEName() const;
+
+    Q_PROPERTY(qulonglong OperatingSystemSupportEnd READ OperatingSystemSupportEnd)
+    qulonglong OperatingSystemSupportEnd() const;
+
+    Q_PROPERTY(QString HomeURL READ HomeURL)
+    QString HomeURL() const;
+
+    Q_PROPERTY(QString HardwareVendor READ HardwareVendor)
+    QString HardwareVendor() const;
+
+    Q_PROPERTY(QString HardwareModel READ HardwareModel)
+    QString HardwareModel() const;
+
+    Q_PROPERTY(QString FirmwareVersion READ FirmwareVersion)
+    QString FirmwareVersion() const;
+
+    Q_PROPERTY(QString FirmwareVendor READ FirmwareVendor)
+    QString FirmwareVendor() const;
+
+    Q_PROPERTY(qulonglong FirmwareDate READ FirmwareDate)
+    qulonglong FirmwareDate() const;
+
+    Q_PROPERTY(QString MachineID READ MachineID)
+    QString MachineID() const;
+
+    Q_PROPERTY(QString BootID READ BootID)
+    QString BootID() const;
+
+    Q_PROPERTY(qulonglong VSockCID READ VSockCID)
+    qulonglong VSockCID() const;
+
+    // org.freedesktop.hostname1.Stats
+    Q_PROPERTY(QVariantMap MethodCalls READ MethodCalls)
+    QVariantMap MethodCalls() const;
+
+    Q_PROPERTY(uint AuthQueueDepth READ AuthQueueDepth)
+    uint AuthQueueDepth() const;
+
+    Q_PROPERTY(uint AuthQueueInFlight READ AuthQueueInFlight)
+    uint AuthQueueInFlight() const;
+
+    Q_PROPERTY(QVariantMap PolkitWait READ PolkitWait)
+    QVariantMap PolkitWait() const;
+
+    Q_PROPERTY(qulonglong RateLimitRejections READ RateLimitRejections)
+    qulonglong RateLimitRejections() const;
+
+public Q_SLOTS:
+    void SetHostname(const QString& hostname, bool interactive);
+    void SetStaticHostname(const QString& hostname, bool interactive);
+    void SetPrettyHostname(const QString& hostname, bool interactive);
+    void SetIconName(const QString& icon, bool interactive);
+    void SetChassis(const QString& chassis, bool interactive);
+    void SetDeployment(const QString& deployment, bool interactive);
+    void SetLocation(const QString& location, bool interactive);
+    // Sets any of PrettyHostname, IconName, Chassis, Deployment and Location
+    // at once, keyed by property name. An empty value resets the field.
+    void SetMachineInfo(const QMap<QString, QString>& fields, bool interactive);
+    QByteArray GetProductUUID(bool interactive);
+    QString GetHardwareSerial();
+    QString Describe();
+
+private:
+    // Everything annotated with EmitsChangedSignal=const. It is read once in
+    // Start(), so property reads are plain copies. Only the os-release part is
+    // refreshed, should that file be replaced by an upgrade.
+    struct ConstProperties
+    {
+        QString defaultHostname;
+        QString kernelName;
+        QString kernelRelease;
+        QString kernelVersion;
+        QString osPrettyName;
+        QString osCPEName;
+        qulonglong osSupportEnd = 0;
+        QString homeURL;
+        SystemInfo::Hardware hardware;
+        qulonglong firmwareDate = 0;
+        QString machineID;
+        QString bootID;
+        qulonglong vsockCID = 0;
+    };
+
+    static ConstProperties readConstProperties();
+    static void readOSRelease(ConstProperties& props);
+    static QVariantMap constPropertyValues(const ConstProperties& props);
+
+    // Rate limits the caller, then asks polkit
+    void authorizeSetter(const QString& actionId,
+                         AuthQueue::Continuation continuation,
+                         const PolkitQt1::DetailsMap& details = {});
+
+    QString readMachineInfo(const QString& key) const;
+    void setMachineInfo(const QString& key,
+                        const QString& value,
+                        const QString& actionId,
+                        const QStringList& changedProperties);
+    void commitMachineInfo(const DBusSavedContext& context,
+                           const EnvFile::Values& changes,
+                           const QStringList& changedProperties);
+    void emitPropertiesChanged(const QStringList& properties);
+    void flushPropertiesChanged();
+
+    void watchFiles();
+    void onFileChanged(const QString& path);
+    QVariantMap mutablePropertyValues() const;
+
+    void refreshDescribe();
+    void invalidateDescribe(const QStringList& properties);
+
+    QDBusConnection m_bus;
+    RateLimiter m_rateLimiter;
+    FileCommitter m_committer;
+    QStringList m_pendingChanges;
+    QTimer m_propertiesChangedTimer;
+    ConstProperties m_const;
+
+    // Parsed contents of the configuration files. They are only re-read when
+    // m_watcher reports a change.
+    QString m_staticHostname;
+    EnvFile::Values m_machineInfo;
+    // Changes handed to m_committer that may not be on disk yet, with empty
+    // values for removed keys
+    EnvFile::Values m_unsavedMachineInfo;
+    FileWatcher* m_watcher{nullptr};
+
+    // Describe() output is assembled from pre-rendered JSON members: one for
+    // all const properties and one per mutable property. A change drops only
+    // the members of the affected properties and the assembled document.
+    QByteArray m_describeConstMembers;
+    QHash<QString, QByteArray> m_describeMembers;
+    QString m_describe;
+    // the transient hostname the cached members were rendered for
+    QString m_describeHostname;
+};
@@ -6,23 +6,50 @@
 #pragma once
 
 #include <optional>
-#include <functional>
 
 #include <sys/types.h>
 
+#include <QList>
 #include <qtypes.h>
 
 namespace OSDep
 {
 
+// Scheduling class of the main thread of a process
+enum class SchedulingClass : quint8
+{
+    Normal,
+    Realtime,
+    Idle,
+    Other
+};
+
+struct ProcessState
+{
+    pid_t pid;
+    uid_t uid;
+    qulonglong startTime;
+    SchedulingClass schedulingClass;
+};
+
 bool Init();
 void Fini();
 
-void ForEachProcess(const std::function<void(pid_t, uid_t, qulonglong)>& f);
+// Reads the whole process table in one pass, reusing the storage of states
+void SnapshotProcesses(QList<ProcessState>& states);
 std::optional<uid_t> GetUIDForPID(pid_t process);
 bool PIDContainsTID(pid_t process, qulonglong thread);
 bool PIDHasNonStandardSchedulingPolicy(pid_t process);
 void ResolvePID(pid_t process, uid_t* userOut, qulonglong* startTimeOut);
+
+// A descriptor referring to one particular process, which stays valid when the
+// pid gets reused. Returns -1 if the process is gone or handles are not available.
+int OpenProcessHandle(pid_t process);
+// Whether the process referred to by the handle is still running, without
+// looking it up in the process table
+bool ProcessHandleIsAlive(int handle);
+void CloseProcessHandle(int handle);
+
 bool SetHighPriority(pid_t process, qulonglong thread, int priority);
 bool SetRealtimePriority(pid_t process, qulonglong thread, uint priority);
 bool SetIdlePriority(pid_t process, qulonglong thread, uint priority);
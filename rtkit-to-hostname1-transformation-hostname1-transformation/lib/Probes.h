@@ -0,0 +1,30 @@
+/*
+ * Copyright (c) 2026 FreeBSD Foundation
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+// Static tracing probes, see probes.d for the list and their arguments.
+// Configure with -DENABLE_PROBES=ON to build them in, e.g.
+//   dtrace -n 'hostnamed$target:::authqueue-dispatch { trace(copyinstr(arg0)); }' -p PID
+//   bpftrace -e 'usdt:/usr/local/libexec/hostnamed:hostnamed:authqueue__dispatch { printf("%s\n", str(arg0)); }'
+// PROBE() takes the name of the generated macro without the provider, e.g.
+// PROBE(AUTHQUEUE_DISPATCH, ...). Its arguments are only evaluated while a
+// tracer is attached, without probes built in never.
+
+#if defined(HAVE_PROBES)
+// generated by dtrace -h from probes.d, on Linux by SystemTap's dtrace, whose
+// _ENABLED() macros read the semaphores emitted by dtrace -G
+#include "HostnamedProbes.h"
+#define PROBE(name, ...) \
+    do { \
+        if (HOSTNAMED_##name##_ENABLED()) \
+            HOSTNAMED_##name(__VA_ARGS__); \
+    } while (0)
+#else
+// keeps variables only passed to probes from being reported as unused
+template<typename... Args>
+inline void probeDisabled(const Args&...) {}
+#define PROBE(name, ...) do { if (false) probeDisabled(__VA_ARGS__); } while (0)
+#endif
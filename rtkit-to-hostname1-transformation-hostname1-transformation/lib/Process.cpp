@@ -5,30 +5,62 @@
 
 #include "Process.h"
 #include "OSDep.h"
+#include "Probes.h"
+
+namespace {
+
+// OSDep::ResolvePID wrapped in probes, fails with user -1 and start time 0
+void resolvePID(pid_t process, uid_t* user, qulonglong* startTime)
+{
+    PROBE(OSDEP_ENTRY, "ResolvePID", process, 0);
+    OSDep::ResolvePID(process, user, startTime);
+    PROBE(OSDEP_RETURN, "ResolvePID", process, *user != -1u && *startTime != 0);
+}
+
+}
 
 Process::Process(qulonglong process)
     : m_process(process)
 {
-    OSDep::ResolvePID(m_process, &m_user, &m_startTime);
-}
+    resolvePID(m_process, &m_user, &m_startTime);
+    if (m_user == -1u || m_startTime == 0)
+        return;
 
-Process::Process(pid_t process, uid_t user, qulonglong startTime)
-    : m_process(process), m_user(user), m_startTime(startTime)
-{}
+    m_handle = OSDep::OpenProcessHandle(m_process);
+    if (m_handle < 0)
+        return;
 
-void Process::ForEach(const std::function<void (Process*)>& f)
+    // The pid might have been reused between resolving and opening. Once the
+    // handle is open, the process it refers to can't change anymore.
+    uid_t user = -1u;
+    qulonglong startTime = 0;
+    resolvePID(m_process, &user, &startTime);
+    if (user != m_user || startTime != m_startTime) {
+        OSDep::CloseProcessHandle(m_handle);
+        m_handle = -1;
+        m_user = -1u;
+        m_startTime = 0;
+    }
+}
+
+Process::~Process()
 {
-    OSDep::ForEachProcess([f](auto pid, auto uid, auto startTime) {
-        Process p(pid, uid, startTime);
-        f(&p);
-    });
+    if (m_handle >= 0)
+        OSDep::CloseProcessHandle(m_handle);
 }
 
 bool Process::IsValid() const
 {
     if (m_user == -1u || m_startTime == 0)
         return false;
-    return *this == Process(m_process);
+    if (m_handle >= 0)
+        return OSDep::ProcessHandleIsAlive(m_handle);
+
+    // no handle, compare with what the process table says now
+    uid_t user = -1u;
+    qulonglong startTime = 0;
+    resolvePID(m_process, &user, &startTime);
+    return user == m_user && startTime == m_startTime;
 }
 
 bool Process::HasNonStandardSchedulingPolicy() const
@@ -43,20 +75,32 @@ bool Process::ContainsThread(qulonglong thread) const
 
 bool Process::SetHighPriority(qulonglong thread, int priority) const
 {
-    return OSDep::SetHighPriority(m_process, thread, priority);
+    PROBE(OSDEP_ENTRY, "SetHighPriority", m_process, thread);
+    bool ok = OSDep::SetHighPriority(m_process, thread, priority);
+    PROBE(OSDEP_RETURN, "SetHighPriority", m_process, ok);
+    return ok;
 }
 
 bool Process::SetRealtimePriority(qulonglong thread, uint priority) const
 {
-    return OSDep::SetRealtimePriority(m_process, thread, priority);
+    PROBE(OSDEP_ENTRY, "SetRealtimePriority", m_process, thread);
+    bool ok = OSDep::SetRealtimePriority(m_process, thread, priority);
+    PROBE(OSDEP_RETURN, "SetRealtimePriority", m_process, ok);
+    return ok;
 }
 
 bool Process::SetIdlePriority(qulonglong thread, uint priority) const
 {
-    return OSDep::SetIdlePriority(m_process, thread, priority);
+    PROBE(OSDEP_ENTRY, "SetIdlePriority", m_process, thread);
+    bool ok = OSDep::SetIdlePriority(m_process, thread, priority);
+    PROBE(OSDEP_RETURN, "SetIdlePriority", m_process, ok);
+    return ok;
 }
 
 bool Process::ResetAllPriorities(qulonglong thread) const
 {
-    return OSDep::ResetAllPriorities(m_process, thread);
+    PROBE(OSDEP_ENTRY, "ResetAllPriorities", m_process, thread);
+    bool ok = OSDep::ResetAllPriorities(m_process, thread);
+    PROBE(OSDEP_RETURN, "ResetAllPriorities", m_process, ok);
+    return ok;
 }
@@ -5,7 +5,8 @@
 
 #pragma once
 
-#include <functional>
+#include <memory>
+#include <tuple>
 
 #include <sys/types.h>
 
@@ -16,10 +17,13 @@ class Process
 public:
     using Ptr = std::shared_ptr<Process>;
 
-    static void ForEach(const std::function<void(Process*)>& f);
-
+    // Resolves the process and takes a handle on it, so that it can be told
+    // apart from a later process with the same pid
     Process(qulonglong process);
-    Process(pid_t process, uid_t user, qulonglong startTime);
+    ~Process();
+
+    Process(const Process&) = delete;
+    Process& operator=(const Process&) = delete;
 
     bool SetHighPriority(qulonglong thread, int priority) const;
     bool SetRealtimePriority(qulonglong thread, uint priority) const;
@@ -31,6 +35,9 @@ public:
     bool ContainsThread(qulonglong thread) const;
     pid_t Pid() const { return m_process; }
     uid_t Uid() const { return m_user; }
+    // -1 if the process could not be opened
+    int Handle() const { return m_handle; }
+    qulonglong StartTime() const { return m_startTime; }
 
     auto tie() const
     {
@@ -40,8 +47,15 @@ public:
     {
         return tie() == rhs.tie();
     }
+protected:
+    // Takes an identity resolved elsewhere, without a handle
+    Process(pid_t process, uid_t user, qulonglong startTime)
+        : m_process(process), m_user(user), m_startTime(startTime)
+    {}
+
 private:
     pid_t m_process;
     uid_t m_user = -1u;
     qulonglong m_startTime = 0;
+    int m_handle = -1;
 };
@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) 2026 FreeBSD Foundation
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <memory>
+
+#include <sys/types.h>
+
+#include <QObject>
+
+class Process;
+
+// Reports the exit of individual processes as it happens. Runs on the event
+// loop of the thread it lives in, with pidfds on Linux and kqueue on FreeBSD.
+class ProcessWatcher : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ProcessWatcher(QObject* parent = nullptr);
+    ~ProcessWatcher();
+
+    // Fails if the process is already gone. On Linux the handle of the process
+    // is reused, elsewhere a pid that is reused right before the call can't be
+    // told apart, so callers should check the identity of the process once it
+    // is watched.
+    bool Watch(const Process& process);
+    void Unwatch(pid_t process);
+    bool IsWatching(pid_t process) const;
+
+Q_SIGNALS:
+    // Emitted once, the process is not watched anymore afterwards
+    void Exited(pid_t process);
+
+private:
+    struct Private;
+    std::unique_ptr<Private> d;
+};
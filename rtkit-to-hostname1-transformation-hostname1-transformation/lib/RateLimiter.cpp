@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2026 FreeBSD Foundation
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <algorithm>
+
+#include "RateLimiter.h"
+
+RateLimiter::RateLimiter(qsizetype capacity)
+    : m_capacity(std::max<qsizetype>(capacity, 1))
+{
+    m_buckets.reserve(m_capacity);
+    m_index.reserve(m_capacity);
+}
+
+void RateLimiter::SetPolicy(const QString& actionId, Policy policy)
+{
+    auto it = m_actions.constFind(actionId);
+    if (it != m_actions.cend()) {
+        m_policies[*it] = policy;
+        return;
+    }
+
+    m_actions.insert(actionId, static_cast<int>(m_policies.size()));
+    m_policies.push_back(policy);
+}
+
+bool RateLimiter::Acquire(const QString& actionId, uid_t user)
+{
+    auto action = m_actions.constFind(actionId);
+    if (action == m_actions.cend())
+        return true;
+
+    const auto& policy = m_policies[*action];
+    Key key{user, *action};
+    auto now = Clock::now();
+
+    int index;
+    auto it = m_index.constFind(key);
+    if (it != m_index.cend()) {
+        index = *it;
+        unlink(index);
+
+        auto& bucket = m_buckets[index];
+        std::chrono::duration<double> elapsed = now - bucket.refilled;
+        bucket.tokens = std::min<double>(policy.burst, bucket.tokens + elapsed.count() * policy.rate);
+        bucket.refilled = now;
+    } else {
+        if (static_cast<qsizetype>(m_buckets.size()) < m_capacity) {
+            index = static_cast<int>(m_buckets.size());
+            m_buckets.push_back({});
+        } else {
+            index = m_tail;
+            unlink(index);
+            m_index.remove(m_buckets[index].key);
+        }
+
+        m_buckets[index] = {key, static_cast<double>(policy.burst), now, -1, -1};
+        m_index.insert(key, index);
+    }
+
+    pushFront(index);
+
+    auto& bucket = m_buckets[index];
+    if (bucket.tokens < 1) {
+        m_rejected++;
+        return false;
+    }
+
+    bucket.tokens -= 1;
+    return true;
+}
+
+void RateLimiter::unlink(int index)
+{
+    auto& bucket = m_buckets[index];
+
+    if (bucket.prev >= 0)
+        m_buckets[bucket.prev].next = bucket.next;
+    else
+        m_head = bucket.next;
+
+    if (bucket.next >= 0)
+        m_buckets[bucket.next].prev = bucket.prev;
+    else
+        m_tail = bucket.prev;
+
+    bucket.prev = bucket.next = -1;
+}
+
+void RateLimiter::pushFront(int index)
+{
+    auto& bucket = m_buckets[index];
+    bucket.prev = -1;
+    bucket.next = m_head;
+
+    if (m_head >= 0)
+        m_buckets[m_head].prev = index;
+    m_head = index;
+
+    if (m_tail < 0)
+        m_tail = index;
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2026 FreeBSD Foundation
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+#include <sys/types.h>
+
+#include <QHash>
+#include <QString>
+
+// Token buckets per (user, action) on the monotonic clock. Each bucket holds up
+// to burst tokens and regains rate tokens per second; a request takes one.
+// The number of buckets is fixed, the least recently used one is reused once
+// they are all taken, which at worst hands a forgotten user a full bucket.
+class RateLimiter
+{
+public:
+    struct Policy
+    {
+        double rate;
+        uint burst;
+    };
+
+    explicit RateLimiter(qsizetype capacity = 1024);
+
+    // Actions without a policy are not limited
+    void SetPolicy(const QString& actionId, Policy policy);
+
+    // Takes a token from the bucket of the user for the action, returns false
+    // if there is none left
+    bool Acquire(const QString& actionId, uid_t user);
+
+    // How many times Acquire() returned false
+    quint64 Rejected() const { return m_rejected; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Key
+    {
+        uid_t user;
+        int action;
+
+        bool operator==(const Key&) const = default;
+    };
+    friend size_t qHash(const Key& key, size_t seed)
+    {
+        return qHashMulti(seed, key.user, key.action);
+    }
+
+    // Buckets are linked in the order of use, most recent first
+    struct Bucket
+    {
+        Key key;
+        double tokens;
+        Clock::time_point refilled;
+        int prev;
+        int next;
+    };
+
+    void unlink(int index);
+    void pushFront(int index);
+
+    QHash<QString, int> m_actions;
+    std::vector<Policy> m_policies;
+
+    std::vector<Bucket> m_buckets;
+    QHash<Key, int> m_index;
+    int m_head{-1};
+    int m_tail{-1};
+    qsizetype m_capacity;
+    quint64 m_rejected{0};
+};
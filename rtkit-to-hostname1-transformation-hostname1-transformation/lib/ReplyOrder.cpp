@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2026 FreeBSD Foundation
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <QMutexLocker>
+
+#include "ReplyOrder.h"
+
+ReplyOrder::Ticket::Ticket(std::shared_ptr<ReplyOrder> order, quint64 sequence)
+    : m_order(std::move(order)), m_sequence(sequence)
+{
+}
+
+ReplyOrder::Ticket::~Ticket()
+{
+    if (!m_sent)
+        m_order->complete(m_sequence, std::nullopt);
+}
+
+void ReplyOrder::Ticket::Send(const QDBusMessage& reply)
+{
+    if (!m_sent.exchange(true))
+        m_order->complete(m_sequence, reply);
+}
+
+ReplyOrder::ReplyOrder(const QDBusConnection& connection)
+    : m_connection(connection)
+{
+}
+
+std::shared_ptr<ReplyOrder::Ticket> ReplyOrder::Next()
+{
+    QMutexLocker lock(&m_mutex);
+    return std::make_shared<Ticket>(shared_from_this(), m_next++);
+}
+
+void ReplyOrder::complete(quint64 sequence, std::optional<QDBusMessage> reply)
+{
+    // sent with the lock held, so that replies from different threads can't
+    // overtake each other on the way to the connection
+    QMutexLocker lock(&m_mutex);
+
+    m_held.emplace(sequence, std::move(reply));
+    while (!m_held.empty() && m_held.begin()->first == m_head) {
+        if (const auto& message = m_held.begin()->second)
+            m_connection.send(*message);
+        m_held.erase(m_held.begin());
+        m_head++;
+    }
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2026 FreeBSD Foundation
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <optional>
+
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QMutex>
+
+// Sends the replies to the calls of one client in the order the calls
+// arrived, while the calls themselves are processed concurrently. A reply
+// that is ready early is held until all earlier ones have gone out.
+// Thread-safe, replies may be sent from any thread.
+class ReplyOrder : public std::enable_shared_from_this<ReplyOrder>
+{
+public:
+    // The place of one call in the order, shared by all copies of its
+    // DBusSavedContext. When the last reference goes away without a reply
+    // being sent, the call counts as answered, so it can't hold up the others.
+    class Ticket
+    {
+    public:
+        Ticket(std::shared_ptr<ReplyOrder> order, quint64 sequence);
+        ~Ticket();
+
+        Ticket(const Ticket&) = delete;
+        Ticket& operator=(const Ticket&) = delete;
+
+        // Only the first reply is sent
+        void Send(const QDBusMessage& reply);
+
+    private:
+        std::shared_ptr<ReplyOrder> m_order;
+        quint64 m_sequence;
+        std::atomic<bool> m_sent = false;
+    };
+
+    explicit ReplyOrder(const QDBusConnection& connection);
+
+    // Takes the place after all calls made so far
+    std::shared_ptr<Ticket> Next();
+
+private:
+    // nullopt skips the call without replying
+    void complete(quint64 sequence, std::optional<QDBusMessage> reply);
+
+    QDBusConnection m_connection;
+    QMutex m_mutex;
+    quint64 m_next = 0;
+    // the call whose reply goes out next
+    quint64 m_head = 0;
+    // replies of later calls, waiting for m_head
+    std::map<quint64, std::optional<QDBusMessage>> m_held;
+};
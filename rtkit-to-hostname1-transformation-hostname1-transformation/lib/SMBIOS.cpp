@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2026 FreeBSD Foundation
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <algorithm>
+
+#include <QList>
+#include <QtEndian>
+
+#include "SMBIOS.h"
+
+// SMBIOS 3.x, 7 Structure definitions
+static constexpr quint8 BIOSInformation = 0;
+static constexpr quint8 SystemInformation = 1;
+static constexpr quint8 ChassisInformation = 3;
+static constexpr quint8 EndOfTable = 127;
+
+static constexpr int HeaderLength = 4;
+
+namespace
+{
+
+bool HasValidChecksum(const QByteArray& data, qsizetype length)
+{
+    if (length <= 0 || length > data.size())
+        return false;
+
+    quint8 sum = 0;
+    for (qsizetype i = 0; i < length; i++)
+        sum += quint8(data[i]);
+    return sum == 0;
+}
+
+template<typename T>
+T Read(const QByteArray& data, qsizetype offset)
+{
+    return qFromLittleEndian<T>(data.constData() + offset);
+}
+
+// Strings follow the formatted area of a structure and are referenced by
+// their 1-based position, 0 meaning none
+QString StringAt(const QList<QByteArrayView>& strings, quint8 index)
+{
+    if (index == 0 || index > strings.size())
+        return {};
+    return QString::fromUtf8(strings[index - 1]).trimmed();
+}
+
+QByteArray DecodeUUID(QByteArrayView raw, const SMBIOS::EntryPoint& entryPoint)
+{
+    // all zeros: not present, all ones: not set
+    if (raw.count('\0') == raw.size() || raw.count('\xff') == raw.size())
+        return {};
+
+    QByteArray uuid = raw.toByteArray();
+
+    // Since 2.6 the first three fields are little endian, see 7.2.1
+    if (entryPoint.major > 2 || (entryPoint.major == 2 && entryPoint.minor >= 6)) {
+        std::reverse(uuid.begin(), uuid.begin() + 4);
+        std::reverse(uuid.begin() + 4, uuid.begin() + 6);
+        std::reverse(uuid.begin() + 6, uuid.begin() + 8);
+    }
+
+    return uuid;
+}
+
+}
+
+namespace SMBIOS
+{
+
+EntryPoint ParseEntryPoint(const QByteArray& data)
+{
+    EntryPoint entryPoint;
+
+    if (data.startsWith("_SM3_") && data.size() >= 0x18) {
+        if (!HasValidChecksum(data, quint8(data[0x06])))
+            return {};
+        entryPoint.major = quint8(data[0x07]);
+        entryPoint.minor = quint8(data[0x08]);
+        entryPoint.tableLength = Read<quint32>(data, 0x0C);
+        entryPoint.tableAddress = Read<quint64>(data, 0x10);
+    } else if (data.startsWith("_SM_") && data.size() >= 0x1F) {
+        if (!HasValidChecksum(data, quint8(data[0x05])))
+            return {};
+        entryPoint.major = quint8(data[0x06]);
+        entryPoint.minor = quint8(data[0x07]);
+        entryPoint.tableLength = Read<quint16>(data, 0x16);
+        entryPoint.tableAddress = Read<quint32>(data, 0x18);
+    } else if (data.startsWith("_DMI_") && data.size() >= 0x0F) {
+        if (!HasValidChecksum(data, 0x0F))
+            return {};
+        entryPoint.major = quint8(data[0x0E]) >> 4;
+        entryPoint.minor = quint8(data[0x0E]) & 0x0F;
+        entryPoint.tableLength = Read<quint16>(data, 0x06);
+        entryPoint.tableAddress = Read<quint32>(data, 0x08);
+    }
+
+    return entryPoint;
+}
+
+bool ParseTable(const EntryPoint& entryPoint, const QByteArray& table, SystemInfo::Hardware& hw)
+{
+    bool haveSystem = false;
+    // the 3.0 entry point only gives an upper bound
+    const qsizetype end = std::min<qsizetype>(table.size(), entryPoint.tableLength);
+
+    QList<QByteArrayView> strings;
+    qsizetype offset = 0;
+    while (offset + HeaderLength <= end) {
+        const quint8 type = quint8(table[offset]);
+        const quint8 length = quint8(table[offset + 1]);
+        if (length < HeaderLength || offset + length > end)
+            break;
+
+        // the string set ends with a double NUL, which is there even if
+        // the structure has no strings
+        strings.clear();
+        qsizetype next = offset + length;
+        while (next < end && table[next] != '\0') {
+            qsizetype nul = table.indexOf('\0', next);
+            if (nul < 0 || nul >= end)
+                return haveSystem;
+            strings << QByteArrayView(table.constData() + next, nul - next);
+            next = nul + 1;
+        }
+        if (next >= end)
+            return haveSystem;
+        next = strings.isEmpty() ? next + 2 : next + 1;
+
+        const QByteArrayView formatted(table.constData() + offset, length);
+        auto byteAt = [&](qsizetype i) -> quint8 { return i < length ? quint8(formatted[i]) : 0; };
+
+        switch (type) {
+        case BIOSInformation:
+            hw.firmwareVendor = StringAt(strings, byteAt(0x04));
+            hw.firmwareVersion = StringAt(strings, byteAt(0x05));
+            hw.firmwareDate = StringAt(strings, byteAt(0x08));
+            break;
+        case SystemInformation:
+            haveSystem = true;
+            hw.vendor = StringAt(strings, byteAt(0x04));
+            hw.model = StringAt(strings, byteAt(0x05));
+            hw.serial = StringAt(strings, byteAt(0x07));
+            if (length >= 0x18)
+                hw.productUUID = DecodeUUID(formatted.sliced(0x08, 16), entryPoint);
+            break;
+        case ChassisInformation:
+            // bit 7 is the chassis lock
+            hw.chassis = ChassisName(byteAt(0x05) & 0x7F);
+            break;
+        }
+
+        if (type == EndOfTable)
+            break;
+        offset = next;
+    }
+
+    return haveSystem;
+}
+
+// SMBIOS 3.x, 7.4.1 System Enclosure or Chassis Types
+QString ChassisName(int type)
+{
+    switch (type) {
+    case 0x03: // Desktop
+    case 0x04: // Low Profile Desktop
+    case 0x06: // Mini Tower
+    case 0x07: // Tower
+    case 0x0D: // All in One
+    case 0x23: // Mini PC
+    case 0x24: // Stick PC
+        return QStringLiteral("desktop");
+    case 0x08: // Portable
+    case 0x09: // Laptop
+    case 0x0A: // Notebook
+    case 0x0E: // Sub Notebook
+        return QStringLiteral("laptop");
+    case 0x0B: // Hand Held
+        return QStringLiteral("handset");
+    case 0x11: // Main Server Chassis
+    case 0x1C: // Blade
+    case 0x1D: // Blade Enclosure
+        return QStringLiteral("server");
+    case 0x1E: // Tablet
+        return QStringLiteral("tablet");
+    case 0x1F: // Convertible
+    case 0x20: // Detachable
+        return QStringLiteral("convertible");
+    case 0x21: // IoT Gateway
+    case 0x22: // Embedded PC
+        return QStringLiteral("embedded");
+    default:
+        return {};
+    }
+}
+
+}
@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) 2026 FreeBSD Foundation
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+
+#include "SystemInfo.h"
+
+// Decoder for the raw SMBIOS entry point and structure table. It only works
+// on buffers, where they come from is up to the platform code.
+namespace SMBIOS
+{
+
+struct EntryPoint
+{
+    // physical address, only needed where the table is read from memory
+    quint64 tableAddress = 0;
+    quint32 tableLength = 0;
+    int major = 0;
+    int minor = 0;
+
+    bool isValid() const { return tableLength != 0; }
+};
+
+// Accepts the 64-bit (_SM3_), 32-bit (_SM_) and legacy (_DMI_) entry points
+EntryPoint ParseEntryPoint(const QByteArray& data);
+
+// Fills hw from the BIOS, System and Chassis structures in a single walk
+// over the table. Returns false if there is no System structure.
+bool ParseTable(const EntryPoint& entryPoint, const QByteArray& table, SystemInfo::Hardware& hw);
+
+// Maps an SMBIOS chassis type to a hostname1 chassis name, empty if there is
+// no good match
+QString ChassisName(int type);
+
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2026 FreeBSD Foundation
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <algorithm>
+#include <bit>
+#include <memory>
+
+#include <QDBusContext>
+#include <QDBusMessage>
+#include <QList>
+#include <QMetaMethod>
+#include <QMetaObject>
+
+#include "Stats.h"
+
+// The handler running on this thread
+static thread_local CallTimer* CurrentCallTimer = nullptr;
+
+void Histogram::Record(std::chrono::nanoseconds duration)
+{
+    auto usec = quint64(std::max<qint64>(0, std::chrono::duration_cast<std::chrono::microseconds>(duration).count()));
+    int bucket = std::min<int>(std::bit_width(usec), Buckets - 1);
+
+    m_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sumUSec.fetch_add(usec, std::memory_order_relaxed);
+}
+
+QVariantMap Histogram::ToVariant() const
+{
+    QList<qulonglong> buckets;
+    buckets.reserve(Buckets);
+    for (const auto& bucket : m_buckets)
+        buckets << bucket.load(std::memory_order_relaxed);
+
+    return {
+        {QStringLiteral("Count"), qulonglong(m_count.load(std::memory_order_relaxed))},
+        {QStringLiteral("SumUSec"), qulonglong(m_sumUSec.load(std::memory_order_relaxed))},
+        {QStringLiteral("Buckets"), QVariant::fromValue(buckets)},
+    };
+}
+
+CallStats * CallStats::getInstance()
+{
+    static auto instance = std::unique_ptr<CallStats>(new CallStats);
+    return instance.get();
+}
+
+void CallStats::Register(const QMetaObject* adaptor)
+{
+    for (int i = adaptor->methodOffset(); i < adaptor->methodCount(); i++) {
+        auto method = adaptor->method(i);
+        if (method.methodType() == QMetaMethod::Slot)
+            m_methods.try_emplace(QString::fromLatin1(method.name()));
+    }
+}
+
+void CallStats::Record(const QString& method, std::chrono::nanoseconds latency, bool failed)
+{
+    auto it = m_methods.find(method);
+    if (it == m_methods.end())
+        return;
+
+    it->second.calls.fetch_add(1, std::memory_order_relaxed);
+    if (failed)
+        it->second.errors.fetch_add(1, std::memory_order_relaxed);
+    it->second.latency.Record(latency);
+}
+
+QVariantMap CallStats::ToVariant() const
+{
+    QVariantMap methods;
+    for (const auto& [name, method] : m_methods) {
+        methods.insert(name, QVariantMap{
+            {QStringLiteral("Calls"), qulonglong(method.calls.load(std::memory_order_relaxed))},
+            {QStringLiteral("Errors"), qulonglong(method.errors.load(std::memory_order_relaxed))},
+            {QStringLiteral("Latency"), method.latency.ToVariant()},
+        });
+    }
+    return methods;
+}
+
+CallTimer::CallTimer(const QDBusContext* context)
+    : m_context(context)
+    , m_started(std::chrono::steady_clock::now())
+    , m_outer(CurrentCallTimer)
+{
+    CurrentCallTimer = this;
+}
+
+CallTimer::~CallTimer()
+{
+    CurrentCallTimer = m_outer;
+
+    if (m_handedOff || !m_context->calledFromDBus())
+        return;
+
+    // without a saved context, only an error reply makes the reply delayed
+    CallStats::getInstance()->Record(m_context->message().member(),
+                                     std::chrono::steady_clock::now() - m_started,
+                                     m_context->isDelayedReply());
+}
+
+std::chrono::steady_clock::time_point CallTimer::HandOff()
+{
+    if (!CurrentCallTimer)
+        return std::chrono::steady_clock::now();
+
+    CurrentCallTimer->m_handedOff = true;
+    return CurrentCallTimer->m_started;
+}
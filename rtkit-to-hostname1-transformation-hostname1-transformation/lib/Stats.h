@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2026 FreeBSD Foundation
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <unordered_map>
+
+#include <QString>
+#include <QVariantMap>
+
+class QDBusContext;
+struct QMetaObject;
+
+// Latencies in fixed power-of-two buckets. Recording is a few relaxed atomic
+// increments and can happen on any thread.
+class Histogram
+{
+public:
+    // Bucket 0 counts durations below 1us, bucket i those in
+    // [2^(i-1), 2^i) us, the last one everything longer
+    static constexpr int Buckets = 32;
+
+    void Record(std::chrono::nanoseconds duration);
+
+    // {"Count": t, "SumUSec": t, "Buckets": at}
+    QVariantMap ToVariant() const;
+
+private:
+    std::array<std::atomic<quint64>, Buckets> m_buckets{};
+    std::atomic<quint64> m_count{0};
+    std::atomic<quint64> m_sumUSec{0};
+};
+
+// Per-method call and error counts and latencies of the D-Bus interfaces this
+// process serves, fed by CallTimer and DBusSavedContext. The latency runs from
+// the moment the method handler was entered to the moment the reply went out.
+class CallStats
+{
+protected:
+    CallStats() = default;
+
+public:
+    static CallStats * getInstance();
+
+    // Adds the methods of an adaptor. Only registered methods are recorded,
+    // which keeps the table fixed once the object is on the bus and lets
+    // Record() run without a lock.
+    void Register(const QMetaObject* adaptor);
+
+    void Record(const QString& method, std::chrono::nanoseconds latency, bool failed);
+
+    // method name -> {"Calls": t, "Errors": t, "Latency": a{sv}}
+    QVariantMap ToVariant() const;
+
+private:
+    struct Method
+    {
+        std::atomic<quint64> calls{0};
+        std::atomic<quint64> errors{0};
+        Histogram latency;
+    };
+
+    std::unordered_map<QString, Method> m_methods;
+};
+
+// Put on the stack of every method handler. A call answered later, through a
+// DBusSavedContext made while the handler runs, is recorded once that reply
+// is sent. Any other call is recorded when the handler returns, as an error if
+// it has sent an error reply.
+class CallTimer
+{
+public:
+    explicit CallTimer(const QDBusContext* context);
+    ~CallTimer();
+
+    CallTimer(const CallTimer&) = delete;
+    CallTimer& operator=(const CallTimer&) = delete;
+
+    // Leaves recording to the DBusSavedContext saved in the running handler
+    // and returns when the handler was entered, or now outside of one
+    static std::chrono::steady_clock::time_point HandOff();
+
+private:
+    const QDBusContext* m_context;
+    std::chrono::steady_clock::time_point m_started;
+    bool m_handedOff = false;
+    CallTimer* m_outer;
+};
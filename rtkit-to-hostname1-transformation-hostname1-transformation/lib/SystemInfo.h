@@ -0,0 +1,37 @@
+/*
+ * Copyright (c) 2026 FreeBSD Foundation
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+
+// Platform-specific sources of the hostname1 properties that don't come from
+// configuration files
+namespace SystemInfo
+{
+
+struct Hardware
+{
+    QString vendor;
+    QString model;
+    QString serial;
+    QString firmwareVersion;
+    QString firmwareVendor;
+    // as reported by the firmware, usually MM/DD/YYYY
+    QString firmwareDate;
+    // raw 16 bytes, empty if unknown
+    QByteArray productUUID;
+    // one of the hostname1 chassis names, empty if unknown
+    QString chassis;
+};
+
+Hardware ReadHardware();
+// 32 lowercase hex digits, empty if unknown
+QString ReadBootID();
+// VMADDR_CID_ANY if not available
+qulonglong ReadVSockCID();
+
+}
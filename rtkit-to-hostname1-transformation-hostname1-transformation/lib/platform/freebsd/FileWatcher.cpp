@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2026 FreeBSD Foundation
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QSet>
+#include <QSocketNotifier>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/event.h>
+#include <sys/stat.h>
+
+#include "FileWatcher.h"
+
+static constexpr u_int FileMask = NOTE_WRITE | NOTE_EXTEND | NOTE_ATTRIB | NOTE_DELETE | NOTE_RENAME;
+// a directory gets NOTE_WRITE whenever an entry is created, removed or renamed
+static constexpr u_int DirectoryMask = NOTE_WRITE;
+
+namespace
+{
+
+struct WatchedFile
+{
+    QString path;
+    QString dir;
+    int fd = -1;
+    ino_t inode = 0;
+};
+
+}
+
+struct FileWatcher::Private
+{
+    int kq = -1;
+    QSocketNotifier* notifier = nullptr;
+    // directory fd -> directory path
+    QHash<int, QString> directories;
+    // directory path -> directory fd
+    QHash<QString, int> directoryFds;
+    QList<WatchedFile> files;
+
+    bool addVnode(int fd, u_int fflags)
+    {
+        struct kevent ev;
+        EV_SET(&ev, fd, EVFILT_VNODE, EV_ADD | EV_CLEAR, fflags, 0, nullptr);
+        return kevent(kq, &ev, 1, nullptr, 0, nullptr) == 0;
+    }
+
+    // (Re)opens the watched file, returns true if it is not the one watched before
+    bool reopen(WatchedFile& file)
+    {
+        struct stat st;
+        bool exists = stat(QFile::encodeName(file.path).constData(), &st) == 0;
+
+        if (exists && file.fd >= 0 && st.st_ino == file.inode)
+            return false;
+        if (!exists && file.fd < 0)
+            return false;
+
+        // closing the descriptor also removes its kevent
+        if (file.fd >= 0) {
+            close(file.fd);
+            file.fd = -1;
+            file.inode = 0;
+        }
+
+        if (exists) {
+            file.fd = open(QFile::encodeName(file.path).constData(), O_RDONLY | O_CLOEXEC);
+            if (file.fd >= 0 && !addVnode(file.fd, FileMask)) {
+                close(file.fd);
+                file.fd = -1;
+            }
+            if (file.fd >= 0)
+                file.inode = st.st_ino;
+        }
+
+        return true;
+    }
+};
+
+FileWatcher::FileWatcher(QObject* parent)
+    : QObject(parent), d(std::make_unique<Private>())
+{
+    d->kq = kqueue();
+    if (d->kq < 0) {
+        qWarning() << "kqueue() failed, file changes will not be noticed";
+        return;
+    }
+
+    d->notifier = new QSocketNotifier(d->kq, QSocketNotifier::Read, this);
+    connect(d->notifier, &QSocketNotifier::activated, this, &FileWatcher::readEvents);
+}
+
+FileWatcher::~FileWatcher()
+{
+    for (const auto& file : d->files)
+        if (file.fd >= 0)
+            close(file.fd);
+    for (int fd : d->directoryFds)
+        close(fd);
+    if (d->kq >= 0)
+        close(d->kq);
+}
+
+bool FileWatcher::Watch(const QString& path)
+{
+    if (d->kq < 0)
+        return false;
+
+    QFileInfo info(path);
+    QString dir = info.absolutePath();
+
+    // vnode events are tied to the file, not to the name, so the directory is
+    // watched as well to learn when the name starts pointing to another file
+    if (!d->directoryFds.contains(dir)) {
+        int fd = open(QFile::encodeName(dir).constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0)
+            return false;
+        if (!d->addVnode(fd, DirectoryMask)) {
+            close(fd);
+            return false;
+        }
+        d->directories.insert(fd, dir);
+        d->directoryFds.insert(dir, fd);
+    }
+
+    WatchedFile file{info.absoluteFilePath(), dir};
+    d->reopen(file);
+    d->files.append(file);
+
+    return true;
+}
+
+void FileWatcher::readEvents()
+{
+    struct kevent events[16];
+    struct timespec timeout = {0, 0};
+    QSet<QString> changed;
+
+    for (;;) {
+        int n = kevent(d->kq, nullptr, 0, events, std::size(events), &timeout);
+        if (n <= 0)
+            break;
+
+        for (int i = 0; i < n; i++) {
+            int fd = static_cast<int>(events[i].ident);
+
+            if (d->directories.contains(fd)) {
+                const QString& dir = d->directories[fd];
+                for (auto& file : d->files)
+                    if (file.dir == dir && d->reopen(file))
+                        changed.insert(file.path);
+                continue;
+            }
+
+            for (auto& file : d->files) {
+                if (file.fd != fd)
+                    continue;
+                changed.insert(file.path);
+                // the name may already point to the new file
+                if (events[i].fflags & (NOTE_DELETE | NOTE_RENAME))
+                    d->reopen(file);
+            }
+        }
+    }
+
+    for (const auto& path : changed)
+        Q_EMIT Changed(path);
+}
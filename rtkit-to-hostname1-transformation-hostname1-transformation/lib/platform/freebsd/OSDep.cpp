@@ -7,8 +7,12 @@
 
 #include <limits.h>
 #include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
 #include <kvm.h>
 #include <sys/param.h>
+#include <sys/event.h>
+#include <sys/priority.h>
 #include <sys/sysctl.h>
 #include <sys/user.h>
 #include <sys/thr.h>
@@ -16,52 +20,96 @@
 
 #include "OSDep.h"
 
-static kvm_t* KVM = nullptr;
-static char KVMErrorBuf[_POSIX2_LINE_MAX];
-static bool Entered = false;
+namespace
+{
+
+// kvm_getprocs() returns a buffer owned by the handle and overwritten by the
+// next call, so every thread gets a handle of its own. They are opened on
+// first use and closed when the thread exits.
+struct KVMHandle
+{
+    kvm_t* kvm = nullptr;
+    char errorBuf[_POSIX2_LINE_MAX];
+
+    ~KVMHandle()
+    {
+        close();
+    }
+
+    kvm_t* get()
+    {
+        if (!kvm)
+            kvm = kvm_openfiles(nullptr, "/dev/null", nullptr, O_RDONLY, errorBuf);
+        return kvm;
+    }
+
+    void close()
+    {
+        if (kvm) {
+            kvm_close(kvm);
+            kvm = nullptr;
+        }
+    }
+};
+
+thread_local KVMHandle KVM;
+
+}
 
 namespace OSDep
 {
 
+// Only checks that kvm is usable, other threads open their handles lazily
 bool Init()
 {
-    if (KVM)
-        Fini();
-
-    KVM = kvm_openfiles(nullptr, "/dev/null", nullptr, O_RDONLY, KVMErrorBuf);
-
-    return KVM != nullptr;
+    return KVM.get() != nullptr;
 }
 void Fini()
 {
-    if (KVM) {
-        kvm_close(KVM);
-        KVM = nullptr;
+    KVM.close();
+}
+
+static SchedulingClass SchedulingClassFromPri(const struct priority& pri)
+{
+    if (pri.pri_class & PRI_FIFO_BIT)
+        return SchedulingClass::Realtime;
+
+    switch (PRI_BASE(pri.pri_class)) {
+    case PRI_TIMESHARE:
+        return SchedulingClass::Normal;
+    case PRI_REALTIME:
+        return SchedulingClass::Realtime;
+    case PRI_IDLE:
+        return SchedulingClass::Idle;
+    default:
+        return SchedulingClass::Other;
     }
 }
 
-void ForEachProcess(const std::function<void(pid_t, uid_t, qulonglong)>& f)
+void SnapshotProcesses(QList<ProcessState>& states)
 {
-    Q_ASSERT(!Entered);
-    Entered = true;
+    states.clear();
+
+    kvm_t* kvm = KVM.get();
+    if (!kvm)
+        return;
 
     int count = 0;
-    struct kinfo_proc *kinfo = kvm_getprocs(KVM, KERN_PROC_PROC, 0, &count);
+    struct kinfo_proc *kinfo = kvm_getprocs(kvm, KERN_PROC_PROC, 0, &count);
+    states.reserve(count);
     for (int i = 0; i < count; i++)
-        f(kinfo->ki_pid, kinfo->ki_uid, kinfo->ki_start.tv_sec);
-
-    Entered = false;
+        states.append({kinfo[i].ki_pid, kinfo[i].ki_uid, static_cast<qulonglong>(kinfo[i].ki_start.tv_sec),
+                       SchedulingClassFromPri(kinfo[i].ki_pri)});
 }
 
 std::optional<uid_t> GetUIDForPID(pid_t process)
 {
-    Q_ASSERT(!Entered);
-    Entered = true;
+    kvm_t* kvm = KVM.get();
+    if (!kvm)
+        return {};
 
     int count = 0;
-    struct kinfo_proc *kinfo = kvm_getprocs(KVM, KERN_PROC_PID, static_cast<pid_t>(process), &count);
-
-    Entered = false;
+    struct kinfo_proc *kinfo = kvm_getprocs(kvm, KERN_PROC_PID, static_cast<pid_t>(process), &count);
 
     if (count < 1)
         return {};
@@ -81,13 +129,12 @@ bool PIDHasNonStandardSchedulingPolicy(pid_t process)
 
 void ResolvePID(pid_t process, uid_t* userOut, qulonglong* startTimeOut)
 {
-    Q_ASSERT(!Entered);
-    Entered = true;
+    kvm_t* kvm = KVM.get();
+    if (!kvm)
+        return;
 
     int count = 0;
-    struct kinfo_proc *kinfo = kvm_getprocs(KVM, KERN_PROC_PID, static_cast<pid_t>(process), &count);
-
-    Entered = false;
+    struct kinfo_proc *kinfo = kvm_getprocs(kvm, KERN_PROC_PID, static_cast<pid_t>(process), &count);
 
     if (count < 1)
         return;
@@ -96,6 +143,38 @@ void ResolvePID(pid_t process, uid_t* userOut, qulonglong* startTimeOut)
     *startTimeOut = kinfo->ki_start.tv_sec;
 }
 
+// Process descriptors can only be obtained with pdfork(2), so the handle is a
+// kqueue that is told about the exit of the process instead
+int OpenProcessHandle(pid_t process)
+{
+    int kq = kqueue();
+    if (kq < 0)
+        return -1;
+
+    // fails with ESRCH if the process is already gone
+    struct kevent ev;
+    EV_SET(&ev, process, EVFILT_PROC, EV_ADD, NOTE_EXIT, 0, nullptr);
+    if (kevent(kq, &ev, 1, nullptr, 0, nullptr) != 0) {
+        close(kq);
+        return -1;
+    }
+
+    return kq;
+}
+
+// The exit event is only polled for, not retrieved: kevent() would dequeue
+// it, and every later check would find the dead process alive again
+bool ProcessHandleIsAlive(int handle)
+{
+    struct pollfd pfd = {handle, POLLIN, 0};
+    return poll(&pfd, 1, 0) == 0;
+}
+
+void CloseProcessHandle(int handle)
+{
+    close(handle);
+}
+
 bool SetHighPriority(pid_t process, qulonglong thread, int priority)
 {
     struct rtprio rtp;
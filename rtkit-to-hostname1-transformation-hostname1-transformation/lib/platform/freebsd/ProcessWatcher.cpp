@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2026 FreeBSD Foundation
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <QDebug>
+#include <QSet>
+#include <QSocketNotifier>
+
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/event.h>
+
+#include "Process.h"
+#include "ProcessWatcher.h"
+
+// One kqueue for all processes, each with a one-shot EVFILT_PROC/NOTE_EXIT
+struct ProcessWatcher::Private
+{
+    int kq = -1;
+    QSocketNotifier* notifier = nullptr;
+    QSet<pid_t> processes;
+
+    void readEvents(ProcessWatcher* q)
+    {
+        struct kevent events[64];
+        struct timespec timeout = {0, 0};
+
+        for (;;) {
+            int n = kevent(kq, nullptr, 0, events, std::size(events), &timeout);
+            if (n <= 0)
+                break;
+
+            for (int i = 0; i < n; i++) {
+                auto process = static_cast<pid_t>(events[i].ident);
+                if (!processes.remove(process))
+                    continue;
+                Q_EMIT q->Exited(process);
+            }
+        }
+    }
+};
+
+ProcessWatcher::ProcessWatcher(QObject* parent)
+    : QObject(parent), d(std::make_unique<Private>())
+{
+    d->kq = kqueue();
+    if (d->kq < 0) {
+        qWarning() << "kqueue() failed, process exits will not be noticed";
+        return;
+    }
+
+    d->notifier = new QSocketNotifier(d->kq, QSocketNotifier::Read, this);
+    connect(d->notifier, &QSocketNotifier::activated, this, [this] { d->readEvents(this); });
+}
+
+ProcessWatcher::~ProcessWatcher()
+{
+    if (d->kq >= 0)
+        close(d->kq);
+}
+
+bool ProcessWatcher::Watch(const Process& proc)
+{
+    pid_t process = proc.Pid();
+    if (d->kq < 0)
+        return false;
+
+    if (d->processes.contains(process))
+        return true;
+
+    // fails with ESRCH if the process is already gone
+    struct kevent ev;
+    EV_SET(&ev, process, EVFILT_PROC, EV_ADD | EV_ONESHOT, NOTE_EXIT, 0, nullptr);
+    if (kevent(d->kq, &ev, 1, nullptr, 0, nullptr) != 0)
+        return false;
+
+    d->processes.insert(process);
+    return true;
+}
+
+void ProcessWatcher::Unwatch(pid_t process)
+{
+    if (!d->processes.remove(process))
+        return;
+
+    struct kevent ev;
+    EV_SET(&ev, process, EVFILT_PROC, EV_DELETE, 0, 0, nullptr);
+    kevent(d->kq, &ev, 1, nullptr, 0, nullptr);
+}
+
+bool ProcessWatcher::IsWatching(pid_t process) const
+{
+    return d->processes.contains(process);
+}
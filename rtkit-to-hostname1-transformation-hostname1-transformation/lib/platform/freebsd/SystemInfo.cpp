@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2026 FreeBSD Foundation
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <QCryptographicHash>
+#include <QHash>
+#include <QUuid>
+
+#include <fcntl.h>
+#include <kenv.h>
+#include <unistd.h>
+#include <sys/param.h>
+#include <sys/sysctl.h>
+#include <sys/time.h>
+
+#include "SMBIOS.h"
+#include "SystemInfo.h"
+
+// Long enough for every entry point format
+static constexpr size_t SMBIOSEntryPointLength = 0x20;
+
+// FreeBSD has no AF_VSOCK, report the same value Linux uses for "no CID"
+static constexpr qulonglong VMADDR_CID_ANY = 0xFFFFFFFFu;
+
+namespace
+{
+
+QString ReadKenv(const char* name)
+{
+    char buf[KENV_MVALLEN + 1];
+    int len = kenv(KENV_GET, name, buf, sizeof(buf));
+    if (len <= 0)
+        return {};
+    return QString::fromUtf8(buf).trimmed();
+}
+
+QByteArray ReadSysctl(const char* name)
+{
+    size_t len = 0;
+    if (sysctlbyname(name, nullptr, &len, nullptr, 0) != 0)
+        return {};
+
+    QByteArray buf(len, Qt::Uninitialized);
+    if (sysctlbyname(name, buf.data(), &len, nullptr, 0) != 0)
+        return {};
+    buf.truncate(len);
+    return buf;
+}
+
+QByteArray ReadPhysical(int memFd, quint64 address, size_t length)
+{
+    QByteArray buf(length, Qt::Uninitialized);
+    ssize_t len = pread(memFd, buf.data(), length, off_t(address));
+    if (len != ssize_t(length))
+        return {};
+    return buf;
+}
+
+// The loader finds the entry point and leaves its physical address behind,
+// the table itself is only reachable through /dev/mem
+bool ReadSMBIOS(SystemInfo::Hardware& hw)
+{
+    bool ok = false;
+    quint64 address = ReadKenv("hint.smbios.0.mem").toULongLong(&ok, 0);
+    if (!ok)
+        return false;
+
+    int memFd = open("/dev/mem", O_RDONLY | O_CLOEXEC);
+    if (memFd < 0)
+        return false;
+
+    auto entryPoint = SMBIOS::ParseEntryPoint(ReadPhysical(memFd, address, SMBIOSEntryPointLength));
+    if (entryPoint.isValid())
+        ok = SMBIOS::ParseTable(entryPoint, ReadPhysical(memFd, entryPoint.tableAddress, entryPoint.tableLength), hw);
+    else
+        ok = false;
+
+    close(memFd);
+    return ok;
+}
+
+// The loader exports the SMBIOS chassis type as its name from the specification
+QString ChassisFromKenv(const QString& type)
+{
+    static const QHash<QString, QString> chassis = {
+        {QStringLiteral("Desktop"), QStringLiteral("desktop")},
+        {QStringLiteral("Low Profile Desktop"), QStringLiteral("desktop")},
+        {QStringLiteral("Mini Tower"), QStringLiteral("desktop")},
+        {QStringLiteral("Tower"), QStringLiteral("desktop")},
+        {QStringLiteral("All in One"), QStringLiteral("desktop")},
+        {QStringLiteral("Mini PC"), QStringLiteral("desktop")},
+        {QStringLiteral("Stick PC"), QStringLiteral("desktop")},
+        {QStringLiteral("Portable"), QStringLiteral("laptop")},
+        {QStringLiteral("Laptop"), QStringLiteral("laptop")},
+        {QStringLiteral("Notebook"), QStringLiteral("laptop")},
+        {QStringLiteral("Sub Notebook"), QStringLiteral("laptop")},
+        {QStringLiteral("Hand Held"), QStringLiteral("handset")},
+        {QStringLiteral("Main Server Chassis"), QStringLiteral("server")},
+        {QStringLiteral("Blade"), QStringLiteral("server")},
+        {QStringLiteral("Blade Enclosure"), QStringLiteral("server")},
+        {QStringLiteral("Tablet"), QStringLiteral("tablet")},
+        {QStringLiteral("Convertible"), QStringLiteral("convertible")},
+        {QStringLiteral("Detachable"), QStringLiteral("convertible")},
+        {QStringLiteral("IoT Gateway"), QStringLiteral("embedded")},
+        {QStringLiteral("Embedded PC"), QStringLiteral("embedded")},
+    };
+
+    return chassis.value(type);
+}
+
+}
+
+namespace SystemInfo
+{
+
+Hardware ReadHardware()
+{
+    Hardware hw;
+
+    // The smbios.* variables hold the same data, decoded by the loader, but
+    // each one is a separate kenv(2) call
+    if (!ReadSMBIOS(hw)) {
+        hw = Hardware();
+        hw.vendor = ReadKenv("smbios.system.maker");
+        hw.model = ReadKenv("smbios.system.product");
+        hw.serial = ReadKenv("smbios.system.serial");
+        hw.firmwareVersion = ReadKenv("smbios.bios.version");
+        hw.firmwareVendor = ReadKenv("smbios.bios.vendor");
+        hw.firmwareDate = ReadKenv("smbios.bios.reldate");
+
+        QUuid uuid(ReadKenv("smbios.system.uuid"));
+        if (!uuid.isNull())
+            hw.productUUID = uuid.toRfc4122();
+
+        hw.chassis = ChassisFromKenv(ReadKenv("smbios.chassis.type"));
+    }
+
+    QByteArray vmGuest = ReadSysctl("kern.vm_guest");
+    if (!vmGuest.isEmpty() && qstrcmp(vmGuest.constData(), "none") != 0)
+        hw.chassis = QStringLiteral("vm");
+
+    return hw;
+}
+
+QString ReadBootID()
+{
+    // There is no boot id in FreeBSD, derive a stable one from the host
+    // identity and the boot time
+    QByteArray hostUUID = ReadSysctl("kern.hostuuid");
+    QByteArray bootTime = ReadSysctl("kern.boottime");
+    if (bootTime.size() != sizeof(struct timeval))
+        return {};
+
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    hash.addData(hostUUID);
+    hash.addData(bootTime);
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+qulonglong ReadVSockCID()
+{
+    return VMADDR_CID_ANY;
+}
+
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2026 FreeBSD Foundation
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QSet>
+#include <QSocketNotifier>
+
+#include <unistd.h>
+#include <sys/inotify.h>
+
+#include "FileWatcher.h"
+
+// Files are replaced by rename(2) more often than not, so the containing
+// directory is watched and events are filtered by name
+static constexpr uint32_t DirectoryMask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE | IN_ONLYDIR;
+
+struct FileWatcher::Private
+{
+    int fd = -1;
+    QSocketNotifier* notifier = nullptr;
+    // watch descriptor -> directory path
+    QHash<int, QString> directories;
+    // directory path -> watched file names in it
+    QHash<QString, QSet<QByteArray>> files;
+};
+
+FileWatcher::FileWatcher(QObject* parent)
+    : QObject(parent), d(std::make_unique<Private>())
+{
+    d->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (d->fd < 0) {
+        qWarning() << "inotify_init1() failed, file changes will not be noticed";
+        return;
+    }
+
+    d->notifier = new QSocketNotifier(d->fd, QSocketNotifier::Read, this);
+    connect(d->notifier, &QSocketNotifier::activated, this, &FileWatcher::readEvents);
+}
+
+FileWatcher::~FileWatcher()
+{
+    if (d->fd >= 0)
+        close(d->fd);
+}
+
+bool FileWatcher::Watch(const QString& path)
+{
+    if (d->fd < 0)
+        return false;
+
+    QFileInfo info(path);
+    QString dir = info.absolutePath();
+
+    if (!d->files.contains(dir)) {
+        int wd = inotify_add_watch(d->fd, QFile::encodeName(dir).constData(), DirectoryMask);
+        if (wd < 0)
+            return false;
+        d->directories.insert(wd, dir);
+    }
+
+    d->files[dir].insert(QFile::encodeName(info.fileName()));
+    return true;
+}
+
+void FileWatcher::readEvents()
+{
+    alignas(struct inotify_event) char buf[4096];
+    QSet<QString> changed;
+
+    for (;;) {
+        ssize_t len = read(d->fd, buf, sizeof(buf));
+        if (len <= 0)
+            break;
+
+        for (ssize_t off = 0; off < len;) {
+            auto* event = reinterpret_cast<struct inotify_event*>(buf + off);
+            off += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                // events were lost, assume everything changed
+                for (auto it = d->files.cbegin(); it != d->files.cend(); ++it)
+                    for (const auto& name : it.value())
+                        changed.insert(it.key() + u'/' + QFile::decodeName(name));
+                continue;
+            }
+
+            if (!event->len)
+                continue;
+
+            QString dir = d->directories.value(event->wd);
+            QByteArray name(event->name);
+            if (d->files.value(dir).contains(name))
+                changed.insert(dir + u'/' + QFile::decodeName(name));
+        }
+    }
+
+    for (const auto& path : changed)
+        Q_EMIT Changed(path);
+}
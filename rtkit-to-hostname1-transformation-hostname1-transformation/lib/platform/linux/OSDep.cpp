@@ -0,0 +1,355 @@
+/*
+ * Copyright (c) 2026 FreeBSD Foundation
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <QtGlobal>
+
+#include <charconv>
+#include <cstring>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#include "OSDep.h"
+
+#ifndef SCHED_RESET_ON_FORK
+#define SCHED_RESET_ON_FORK 0x40000000
+#endif
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open 434
+#endif
+#ifndef SCHED_DEADLINE
+#define SCHED_DEADLINE 6
+#endif
+
+// Directory fd for /proc, opened once in Init(). Every per-process lookup is
+// done relative to it, so walking the process table never builds a full path.
+// Lookups through openat() and friends are safe from any thread; reading the
+// directory itself moves the file offset, so every walk opens its own fd.
+static int ProcFd = -1;
+
+namespace
+{
+
+// Layout of the records returned by getdents64(2)
+struct LinuxDirent64
+{
+    ino64_t d_ino;
+    off64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+// "<pid>/task/<tid>" with both ids at most 20 digits each
+constexpr size_t PathBufSize = 64;
+// /proc/<pid>/stat is a single line well below this size even with a 64 byte comm
+constexpr size_t StatBufSize = 1024;
+constexpr size_t DirentBufSize = 32768;
+
+bool ParsePid(const char* name, pid_t* pidOut)
+{
+    pid_t pid = 0;
+    auto end = name + strlen(name);
+    auto [ptr, ec] = std::from_chars(name, end, pid);
+    if (ec != std::errc() || ptr != end || pid <= 0)
+        return false;
+    *pidOut = pid;
+    return true;
+}
+
+// Formats "<pid><suffix>" into buf without touching the heap
+const char* FormatPidPath(char (&buf)[PathBufSize], pid_t pid, const char* suffix)
+{
+    auto [ptr, ec] = std::to_chars(buf, buf + PathBufSize - 1, pid);
+    Q_ASSERT(ec == std::errc());
+    size_t suffixLen = strlen(suffix);
+    Q_ASSERT(ptr + suffixLen < buf + PathBufSize);
+    memcpy(ptr, suffix, suffixLen + 1);
+    return buf;
+}
+
+// Reads the stat file of a process and returns the uid owning the process and
+// its start time (in clock ticks since boot, field 22 of proc_pid_stat(5)).
+// If policyOut is given, the scheduling policy of the main thread (field 41) is
+// read as well.
+//
+// The uid is taken from the owner of the stat file, which procfs sets to the
+// effective uid of the process. Non-dumpable processes are reported as owned by
+// root, which makes them ineligible for any priority change - as intended.
+bool ReadStat(int dirFd, const char* statPath, uid_t* userOut, qulonglong* startTimeOut,
+              int* policyOut = nullptr)
+{
+    char buf[StatBufSize];
+
+    int fd = openat(dirFd, statPath, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+
+    ssize_t len = pread(fd, buf, sizeof(buf) - 1, 0);
+    close(fd);
+    if (len <= 0)
+        return false;
+    buf[len] = '\0';
+    const char* end = buf + len;
+
+    // comm may contain spaces and parentheses, so start after the last ')'
+    const char* p = strrchr(buf, ')');
+    if (!p)
+        return false;
+    p++;
+
+    // Moves p to the start of the given field, counting from the current one
+    int current = 3;
+    auto seekField = [&p, &current](int field) {
+        for (; current <= field; current++) {
+            while (*p == ' ')
+                p++;
+            if (current == field)
+                return true;
+            while (*p && *p != ' ')
+                p++;
+            if (!*p)
+                return false;
+        }
+        return false;
+    };
+
+    qulonglong startTime = 0;
+    if (!seekField(22))
+        return false;
+    if (std::from_chars(p, end, startTime).ec != std::errc())
+        return false;
+
+    if (policyOut) {
+        int policy = 0;
+        if (!seekField(41))
+            return false;
+        if (std::from_chars(p, end, policy).ec != std::errc())
+            return false;
+        *policyOut = policy;
+    }
+
+    *userOut = st.st_uid;
+    *startTimeOut = startTime;
+    return true;
+}
+
+OSDep::SchedulingClass SchedulingClassFromPolicy(int policy)
+{
+    switch (policy & ~SCHED_RESET_ON_FORK) {
+    case SCHED_OTHER:
+        return OSDep::SchedulingClass::Normal;
+    case SCHED_FIFO:
+    case SCHED_RR:
+    case SCHED_DEADLINE:
+        return OSDep::SchedulingClass::Realtime;
+    case SCHED_IDLE:
+        return OSDep::SchedulingClass::Idle;
+    default:
+        return OSDep::SchedulingClass::Other;
+    }
+}
+
+// Calls f for every numeric entry of the directory referred by dirFd
+template<typename F>
+void ForEachPidEntry(int dirFd, F&& f)
+{
+    alignas(LinuxDirent64) char buf[DirentBufSize];
+
+    if (lseek(dirFd, 0, SEEK_SET) != 0)
+        return;
+
+    for (;;) {
+        long n = syscall(SYS_getdents64, dirFd, buf, sizeof(buf));
+        if (n <= 0)
+            break;
+
+        for (long off = 0; off < n;) {
+            auto* d = reinterpret_cast<LinuxDirent64*>(buf + off);
+            off += d->d_reclen;
+
+            if (d->d_type != DT_DIR && d->d_type != DT_UNKNOWN)
+                continue;
+
+            pid_t pid;
+            if (ParsePid(d->d_name, &pid))
+                f(pid);
+        }
+    }
+}
+
+bool ResetThread(pid_t thread)
+{
+    struct sched_param param{};
+    bool ret = sched_setscheduler(thread, SCHED_OTHER, &param) == 0;
+    ret &= setpriority(PRIO_PROCESS, static_cast<id_t>(thread), 0) == 0;
+    return ret;
+}
+
+}
+
+namespace OSDep
+{
+
+bool Init()
+{
+    if (ProcFd >= 0)
+        Fini();
+
+    ProcFd = open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+    return ProcFd >= 0;
+}
+
+void Fini()
+{
+    if (ProcFd >= 0) {
+        close(ProcFd);
+        ProcFd = -1;
+    }
+}
+
+void SnapshotProcesses(QList<ProcessState>& states)
+{
+    states.clear();
+
+    int dirFd = openat(ProcFd, ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dirFd < 0)
+        return;
+
+    ForEachPidEntry(dirFd, [&states](pid_t pid) {
+        char path[PathBufSize];
+        uid_t uid;
+        qulonglong startTime;
+        int policy;
+
+        // the process might have exited since getdents64() listed it
+        if (ReadStat(ProcFd, FormatPidPath(path, pid, "/stat"), &uid, &startTime, &policy))
+            states.append({pid, uid, startTime, SchedulingClassFromPolicy(policy)});
+    });
+
+    close(dirFd);
+}
+
+std::optional<uid_t> GetUIDForPID(pid_t process)
+{
+    char path[PathBufSize];
+    struct stat st;
+
+    if (fstatat(ProcFd, FormatPidPath(path, process, ""), &st, 0) != 0)
+        return {};
+    return st.st_uid;
+}
+
+bool PIDContainsTID(pid_t process, qulonglong thread)
+{
+    return syscall(SYS_tgkill, process, static_cast<pid_t>(thread), 0) == 0;
+}
+
+bool PIDHasNonStandardSchedulingPolicy(pid_t process)
+{
+    int policy = sched_getscheduler(process);
+    return policy >= 0 && (policy & ~SCHED_RESET_ON_FORK) != SCHED_OTHER;
+}
+
+void ResolvePID(pid_t process, uid_t* userOut, qulonglong* startTimeOut)
+{
+    char path[PathBufSize];
+    uid_t uid;
+    qulonglong startTime;
+
+    if (!ReadStat(ProcFd, FormatPidPath(path, process, "/stat"), &uid, &startTime))
+        return;
+
+    *userOut = uid;
+    *startTimeOut = startTime;
+}
+
+// A pidfd polls readable once its process has exited
+int OpenProcessHandle(pid_t process)
+{
+    return static_cast<int>(syscall(SYS_pidfd_open, process, 0));
+}
+
+bool ProcessHandleIsAlive(int handle)
+{
+    struct pollfd pfd = {handle, POLLIN, 0};
+    return poll(&pfd, 1, 0) == 0;
+}
+
+void CloseProcessHandle(int handle)
+{
+    close(handle);
+}
+
+// On Linux nice values and scheduling policies are per-thread, so everything
+// below operates on the thread id. Thread 0 refers to the main thread.
+
+bool SetHighPriority(pid_t process, qulonglong thread, int priority)
+{
+    pid_t tid = thread ? static_cast<pid_t>(thread) : process;
+
+    struct sched_param param{};
+    bool ret = sched_setscheduler(tid, SCHED_OTHER | SCHED_RESET_ON_FORK, &param) == 0;
+
+    ret &= setpriority(PRIO_PROCESS, static_cast<id_t>(tid), priority) == 0;
+    return ret;
+}
+
+bool SetRealtimePriority(pid_t process, qulonglong thread, uint priority)
+{
+    pid_t tid = thread ? static_cast<pid_t>(thread) : process;
+
+    struct sched_param param{};
+    param.sched_priority = static_cast<int>(priority);
+
+    return sched_setscheduler(tid, SCHED_RR | SCHED_RESET_ON_FORK, &param) == 0;
+}
+
+bool SetIdlePriority(pid_t process, qulonglong thread, uint priority)
+{
+    // SCHED_IDLE has no static priority levels
+    Q_UNUSED(priority);
+
+    pid_t tid = thread ? static_cast<pid_t>(thread) : process;
+
+    struct sched_param param{};
+
+    return sched_setscheduler(tid, SCHED_IDLE | SCHED_RESET_ON_FORK, &param) == 0;
+}
+
+bool ResetAllPriorities(pid_t process, qulonglong thread)
+{
+    if (thread)
+        return ResetThread(static_cast<pid_t>(thread));
+
+    char path[PathBufSize];
+    int taskFd = openat(ProcFd, FormatPidPath(path, process, "/task"),
+                        O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (taskFd < 0)
+        return false;
+
+    bool ret = true;
+    ForEachPidEntry(taskFd, [&ret](pid_t tid) {
+        ret &= ResetThread(tid);
+    });
+
+    close(taskFd);
+    return ret;
+}
+
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2026 FreeBSD Foundation
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <QHash>
+#include <QSocketNotifier>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "OSDep.h"
+#include "Process.h"
+#include "ProcessWatcher.h"
+
+// A pidfd polls readable once its process has exited
+struct ProcessWatcher::Private
+{
+    struct Watch
+    {
+        int fd;
+        QSocketNotifier* notifier;
+    };
+    QHash<pid_t, Watch> watches;
+
+    void remove(pid_t process)
+    {
+        // may be called from the notifier's own signal
+        auto watch = watches.take(process);
+        watch.notifier->setEnabled(false);
+        watch.notifier->deleteLater();
+        close(watch.fd);
+    }
+};
+
+ProcessWatcher::ProcessWatcher(QObject* parent)
+    : QObject(parent), d(std::make_unique<Private>())
+{
+}
+
+ProcessWatcher::~ProcessWatcher()
+{
+    // the notifiers are children and go away with us
+    for (const auto& watch : std::as_const(d->watches))
+        close(watch.fd);
+}
+
+bool ProcessWatcher::Watch(const Process& proc)
+{
+    pid_t process = proc.Pid();
+    if (d->watches.contains(process))
+        return true;
+
+    // the pidfd held by the process refers to it even if the pid got reused
+    int fd = proc.Handle() >= 0 ? fcntl(proc.Handle(), F_DUPFD_CLOEXEC, 0)
+                                : OSDep::OpenProcessHandle(process);
+    if (fd < 0)
+        return false;
+
+    auto* notifier = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+    connect(notifier, &QSocketNotifier::activated, this, [this, process] {
+        d->remove(process);
+        Q_EMIT Exited(process);
+    });
+
+    d->watches.insert(process, {fd, notifier});
+    return true;
+}
+
+void ProcessWatcher::Unwatch(pid_t process)
+{
+    if (d->watches.contains(process))
+        d->remove(process);
+}
+
+bool ProcessWatcher::IsWatching(pid_t process) const
+{
+    return d->watches.contains(process);
+}
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2026 FreeBSD Foundation
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <QFile>
+#include <QUuid>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <linux/vm_sockets.h>
+
+#include "SMBIOS.h"
+#include "SystemInfo.h"
+
+static const QString DMIPath = QStringLiteral("/sys/class/dmi/id/");
+static const QString SMBIOSEntryPointPath = QStringLiteral("/sys/firmware/dmi/tables/smbios_entry_point");
+static const QString SMBIOSTablePath = QStringLiteral("/sys/firmware/dmi/tables/DMI");
+
+namespace
+{
+
+QByteArray ReadFile(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return {};
+    return file.readAll();
+}
+
+QByteArray ReadSysfs(const QString& path)
+{
+    return ReadFile(path).trimmed();
+}
+
+QString ReadDMI(const char* name)
+{
+    return QString::fromUtf8(ReadSysfs(DMIPath + QLatin1String(name)));
+}
+
+bool RunningUnderHypervisor()
+{
+    QFile cpuinfo(QStringLiteral("/proc/cpuinfo"));
+    if (!cpuinfo.open(QIODevice::ReadOnly))
+        return false;
+
+    // every CPU lists the same flags, the first entry is enough
+    while (!cpuinfo.atEnd()) {
+        QByteArray line = cpuinfo.readLine();
+        if (line.startsWith("flags"))
+            return line.split(' ').contains("hypervisor");
+    }
+    return false;
+}
+
+}
+
+namespace SystemInfo
+{
+
+Hardware ReadHardware()
+{
+    Hardware hw;
+
+    // The raw tables give everything in one go. The files under DMIPath are
+    // decoded from the same tables by the kernel, they are only used where
+    // the tables are not exported.
+    auto entryPoint = SMBIOS::ParseEntryPoint(ReadFile(SMBIOSEntryPointPath));
+    if (!entryPoint.isValid() || !SMBIOS::ParseTable(entryPoint, ReadFile(SMBIOSTablePath), hw)) {
+        hw = Hardware();
+        hw.vendor = ReadDMI("sys_vendor");
+        hw.model = ReadDMI("product_name");
+        hw.serial = ReadDMI("product_serial");
+        hw.firmwareVersion = ReadDMI("bios_version");
+        hw.firmwareVendor = ReadDMI("bios_vendor");
+        hw.firmwareDate = ReadDMI("bios_date");
+
+        QUuid uuid(ReadDMI("product_uuid"));
+        if (!uuid.isNull())
+            hw.productUUID = uuid.toRfc4122();
+
+        hw.chassis = SMBIOS::ChassisName(ReadDMI("chassis_type").toInt());
+    }
+
+    if (RunningUnderHypervisor())
+        hw.chassis = QStringLiteral("vm");
+
+    return hw;
+}
+
+QString ReadBootID()
+{
+    QUuid uuid(QString::fromLatin1(ReadSysfs(QStringLiteral("/proc/sys/kernel/random/boot_id"))));
+    if (uuid.isNull())
+        return {};
+    return QString::fromLatin1(uuid.toRfc4122().toHex());
+}
+
+qulonglong ReadVSockCID()
+{
+    int fd = open("/dev/vsock", O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return VMADDR_CID_ANY;
+
+    unsigned int cid = VMADDR_CID_ANY;
+    if (ioctl(fd, IOCTL_VM_SOCKETS_GET_LOCAL_CID, &cid) < 0)
+        cid = VMADDR_CID_ANY;
+
+    close(fd);
+    return cid;
+}
+
+}
@@ -0,0 +1,540 @@
+/*-*- Mode: C; c-basic-offset: 8 -*-*/
+
+/***
+        Copyright (c) 2026 FreeBSD Foundation
+        SPDX-License-Identifier: BSD-3-Clause
+***/
+
+#include <errno.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/thr.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include <dbus/dbus.h>
+
+#include "load.h"
+#include "rtkit.h"
+
+/* What the daemon replies with when the rate limiter rejects a call,
+ * see Daemon::onCallerResolved(). It shares the error name with a
+ * polkit denial, only the message tells them apart. */
+#define RATE_LIMITED_MESSAGE "You are calling too often"
+
+/* Bucket i counts latencies below 2^i usec, the last one everything
+ * above */
+#define HISTOGRAM_BUCKETS 24
+
+/* Lets every thread connect to the bus before the storm starts */
+#define START_DELAY_USEC 1000000ULL
+
+enum method {
+        METHOD_REALTIME,
+        METHOD_REALTIME_WITH_PID,
+        METHOD_HIGH_PRIORITY,
+        METHOD_HIGH_PRIORITY_WITH_PID,
+        _METHOD_MAX
+};
+
+static const char * const method_names[_METHOD_MAX] = {
+        [METHOD_REALTIME] = "MakeThreadRealtime",
+        [METHOD_REALTIME_WITH_PID] = "MakeThreadRealtimeWithPID",
+        [METHOD_HIGH_PRIORITY] = "MakeThreadHighPriority",
+        [METHOD_HIGH_PRIORITY_WITH_PID] = "MakeThreadHighPriorityWithPID",
+};
+
+static const char * const method_options[_METHOD_MAX] = {
+        [METHOD_REALTIME] = "realtime",
+        [METHOD_REALTIME_WITH_PID] = "realtime-with-pid",
+        [METHOD_HIGH_PRIORITY] = "high-priority",
+        [METHOD_HIGH_PRIORITY_WITH_PID] = "high-priority-with-pid",
+};
+
+struct method_stats {
+        unsigned long long calls;
+        unsigned long long rate_limited;
+        unsigned long long denied;
+        unsigned long long failed;
+        unsigned long long total_usec;
+        unsigned long long max_usec;
+        unsigned long long histogram[HISTOGRAM_BUCKETS];
+};
+
+struct stats {
+        struct method_stats methods[_METHOD_MAX];
+        /* threads that never got on the bus, and so made no calls */
+        unsigned long long connect_failed;
+};
+
+struct options {
+        unsigned processes;
+        unsigned threads;
+        unsigned calls;
+        /* calls per second and thread, 0 for back to back */
+        double rate;
+        enum method methods[_METHOD_MAX];
+        unsigned n_methods;
+        int priority;
+        int nice_level;
+};
+
+struct worker {
+        const struct options *options;
+        unsigned index;
+        unsigned long long start_usec;
+        struct stats stats;
+};
+
+static unsigned long long now_usec(void) {
+        struct timespec ts;
+
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (unsigned long long) ts.tv_sec * 1000000ULL + (unsigned long long) ts.tv_nsec / 1000ULL;
+}
+
+static void sleep_until_usec(unsigned long long usec) {
+        struct timespec ts;
+
+        ts.tv_sec = (time_t) (usec / 1000000ULL);
+        ts.tv_nsec = (long) (usec % 1000000ULL) * 1000L;
+
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+                ;
+}
+
+static pid_t current_tid(void) {
+        long ret;
+        thr_self(&ret);
+        return (pid_t) ret;
+}
+
+static void record(struct method_stats *s, unsigned long long usec) {
+        unsigned bucket = 0;
+
+        while (bucket < HISTOGRAM_BUCKETS - 1 && usec >= (1ULL << bucket))
+                bucket++;
+
+        s->histogram[bucket]++;
+        s->total_usec += usec;
+        if (usec > s->max_usec)
+                s->max_usec = usec;
+}
+
+static void merge(struct stats *to, const struct stats *from) {
+        unsigned m, i;
+
+        for (m = 0; m < _METHOD_MAX; m++) {
+                struct method_stats *t = &to->methods[m];
+                const struct method_stats *f = &from->methods[m];
+
+                t->calls += f->calls;
+                t->rate_limited += f->rate_limited;
+                t->denied += f->denied;
+                t->failed += f->failed;
+                t->total_usec += f->total_usec;
+                if (f->max_usec > t->max_usec)
+                        t->max_usec = f->max_usec;
+                for (i = 0; i < HISTOGRAM_BUCKETS; i++)
+                        t->histogram[i] += f->histogram[i];
+        }
+
+        to->connect_failed += from->connect_failed;
+}
+
+/* Same as rtkit_make_realtime() and friends, but keeps the error
+ * around so that rate limiting can be told from other denials */
+static DBusMessage *new_call(const struct options *o, enum method method) {
+        DBusMessage *m;
+        dbus_uint64_t process = (dbus_uint64_t) getpid();
+        dbus_uint64_t thread = (dbus_uint64_t) current_tid();
+        dbus_uint32_t priority = (dbus_uint32_t) o->priority;
+        dbus_int32_t nice_level = (dbus_int32_t) o->nice_level;
+        dbus_bool_t ok;
+
+        if (!(m = dbus_message_new_method_call(
+                              RTKIT_SERVICE_NAME,
+                              RTKIT_OBJECT_PATH,
+                              "org.freedesktop.RealtimeKit1",
+                              method_names[method])))
+                return NULL;
+
+        switch (method) {
+        case METHOD_REALTIME:
+                ok = dbus_message_append_args(m,
+                                              DBUS_TYPE_UINT64, &thread,
+                                              DBUS_TYPE_UINT32, &priority,
+                                              DBUS_TYPE_INVALID);
+                break;
+        case METHOD_REALTIME_WITH_PID:
+                ok = dbus_message_append_args(m,
+                                              DBUS_TYPE_UINT64, &process,
+                                              DBUS_TYPE_UINT64, &thread,
+                                              DBUS_TYPE_UINT32, &priority,
+                                              DBUS_TYPE_INVALID);
+                break;
+        case METHOD_HIGH_PRIORITY:
+                ok = dbus_message_append_args(m,
+                                              DBUS_TYPE_UINT64, &thread,
+                                              DBUS_TYPE_INT32, &nice_level,
+                                              DBUS_TYPE_INVALID);
+                break;
+        default:
+                ok = dbus_message_append_args(m,
+                                              DBUS_TYPE_UINT64, &process,
+                                              DBUS_TYPE_UINT64, &thread,
+                                              DBUS_TYPE_INT32, &nice_level,
+                                              DBUS_TYPE_INVALID);
+                break;
+        }
+
+        if (!ok) {
+                dbus_message_unref(m);
+                return NULL;
+        }
+
+        return m;
+}
+
+static void call(DBusConnection *bus, const struct options *o, enum method method, struct method_stats *s) {
+        DBusMessage *m, *r;
+        DBusError error;
+        unsigned long long begin;
+
+        dbus_error_init(&error);
+        s->calls++;
+
+        if (!(m = new_call(o, method))) {
+                s->failed++;
+                return;
+        }
+
+        begin = now_usec();
+        r = dbus_connection_send_with_reply_and_block(bus, m, -1, &error);
+        record(s, now_usec() - begin);
+
+        if (r)
+                dbus_set_error_from_message(&error, r);
+
+        if (dbus_error_is_set(&error)) {
+                if (strcmp(error.name, DBUS_ERROR_ACCESS_DENIED) != 0)
+                        s->failed++;
+                else if (error.message && strcmp(error.message, RATE_LIMITED_MESSAGE) == 0)
+                        s->rate_limited++;
+                else
+                        s->denied++;
+        }
+
+        dbus_message_unref(m);
+        if (r)
+                dbus_message_unref(r);
+        dbus_error_free(&error);
+}
+
+static void *run_worker(void *userdata) {
+        struct worker *w = userdata;
+        const struct options *o = w->options;
+        DBusConnection *bus;
+        DBusError error;
+        unsigned long long next;
+        unsigned i;
+
+        dbus_error_init(&error);
+
+        /* a connection of its own, like every client of an audio
+         * server has */
+        if (!(bus = dbus_bus_get_private(DBUS_BUS_SYSTEM, &error))) {
+                fprintf(stderr, "Failed to connect to system bus: %s\n", error.message);
+                dbus_error_free(&error);
+                w->stats.connect_failed++;
+                return NULL;
+        }
+
+        sleep_until_usec(w->start_usec);
+        next = w->start_usec;
+
+        for (i = 0; i < o->calls; i++) {
+                /* threads start at different methods, so the mix is
+                 * even at any point in time */
+                enum method method = o->methods[(w->index + i) % o->n_methods];
+
+                call(bus, o, method, &w->stats.methods[method]);
+
+                if (o->rate > 0) {
+                        next += (unsigned long long) (1000000.0 / o->rate);
+                        sleep_until_usec(next);
+                }
+        }
+
+        dbus_connection_close(bus);
+        dbus_connection_unref(bus);
+
+        return NULL;
+}
+
+/* Runs in each forked process, sums up its threads and hands the
+ * result to the parent through fd */
+static int run_process(const struct options *o, unsigned process, unsigned long long start_usec, int fd) {
+        struct worker *workers;
+        pthread_t *threads;
+        struct stats total;
+        unsigned i;
+        int ret = 0;
+
+        dbus_threads_init_default();
+
+        workers = calloc(o->threads, sizeof(struct worker));
+        threads = calloc(o->threads, sizeof(pthread_t));
+        if (!workers || !threads) {
+                fprintf(stderr, "Out of memory\n");
+                return 1;
+        }
+
+        for (i = 0; i < o->threads; i++) {
+                workers[i].options = o;
+                workers[i].index = process * o->threads + i;
+                workers[i].start_usec = start_usec;
+
+                if ((errno = pthread_create(&threads[i], NULL, run_worker, &workers[i])) != 0) {
+                        fprintf(stderr, "pthread_create() failed: %s\n", strerror(errno));
+                        ret = 1;
+                        break;
+                }
+        }
+
+        memset(&total, 0, sizeof(total));
+        while (i-- > 0) {
+                pthread_join(threads[i], NULL);
+                merge(&total, &workers[i].stats);
+        }
+
+        if (total.connect_failed > 0)
+                ret = 1;
+
+        if (write(fd, &total, sizeof(total)) != (ssize_t) sizeof(total)) {
+                fprintf(stderr, "Failed to report results: %s\n", strerror(errno));
+                ret = 1;
+        }
+
+        free(workers);
+        free(threads);
+
+        return ret;
+}
+
+static void print_stats(const struct stats *total) {
+        unsigned m, i;
+
+        if (total->connect_failed > 0)
+                printf("%llu threads failed to connect to the bus\n", total->connect_failed);
+
+        for (m = 0; m < _METHOD_MAX; m++) {
+                const struct method_stats *s = &total->methods[m];
+
+                if (s->calls == 0)
+                        continue;
+
+                printf("%s: %llu calls, %llu rate limited, %llu denied, %llu failed, avg %llu usec, max %llu usec\n",
+                       method_names[m], s->calls, s->rate_limited, s->denied, s->failed,
+                       s->total_usec / s->calls, s->max_usec);
+
+                for (i = 0; i < HISTOGRAM_BUCKETS; i++) {
+                        if (s->histogram[i] == 0)
+                                continue;
+
+                        if (i == HISTOGRAM_BUCKETS - 1)
+                                printf("\t>= %llu usec: %llu\n", 1ULL << (i - 1), s->histogram[i]);
+                        else
+                                printf("\t< %llu usec: %llu\n", 1ULL << i, s->histogram[i]);
+                }
+        }
+}
+
+static int parse_methods(struct options *o, const char *list) {
+        char *copy, *token, *state = NULL;
+        unsigned m;
+
+        o->n_methods = 0;
+
+        if (!(copy = strdup(list)))
+                return -ENOMEM;
+
+        for (token = strtok_r(copy, ",", &state); token; token = strtok_r(NULL, ",", &state)) {
+                for (m = 0; m < _METHOD_MAX; m++)
+                        if (strcmp(token, method_options[m]) == 0)
+                                break;
+
+                if (m == _METHOD_MAX || o->n_methods == _METHOD_MAX) {
+                        free(copy);
+                        return -EINVAL;
+                }
+
+                o->methods[o->n_methods++] = (enum method) m;
+        }
+
+        free(copy);
+        return o->n_methods > 0 ? 0 : -EINVAL;
+}
+
+void load_usage(const char *name) {
+        printf("%s [OPTIONS...]\n\n"
+               "Without options, makes the calling thread high priority and then\n"
+               "realtime once. With any of the options below, generates load:\n\n"
+               "  -p, --processes=N     Number of processes to fork (default 4)\n"
+               "  -t, --threads=N       Threads per process (default 8)\n"
+               "  -c, --calls=N         Calls per thread (default 100)\n"
+               "  -r, --rate=N          Calls per second and thread, 0 for no pause (default 0)\n"
+               "  -m, --methods=LIST    Comma separated list out of realtime, realtime-with-pid,\n"
+               "                        high-priority, high-priority-with-pid (default all)\n"
+               "      --priority=N      Realtime priority to ask for (default 1)\n"
+               "      --nice=N          Nice level to ask for (default -1)\n"
+               "  -h, --help            Show this help\n",
+               name);
+}
+
+int run_load(int argc, char *argv[]) {
+        enum {
+                ARG_PRIORITY = 0x100,
+                ARG_NICE,
+        };
+
+        static const struct option long_options[] = {
+                { "processes", required_argument, NULL, 'p' },
+                { "threads",   required_argument, NULL, 't' },
+                { "calls",     required_argument, NULL, 'c' },
+                { "rate",      required_argument, NULL, 'r' },
+                { "methods",   required_argument, NULL, 'm' },
+                { "priority",  required_argument, NULL, ARG_PRIORITY },
+                { "nice",      required_argument, NULL, ARG_NICE },
+                { "help",      no_argument,       NULL, 'h' },
+                { NULL,        0,                 NULL, 0 }
+        };
+
+        struct options o = {
+                .processes = 4,
+                .threads = 8,
+                .calls = 100,
+                .rate = 0,
+                .priority = 1,
+                .nice_level = -1,
+        };
+        struct stats total;
+        unsigned long long start_usec, elapsed_usec;
+        unsigned i, started = 0;
+        int c, ret = 0;
+        int *fds;
+        pid_t *pids;
+
+        parse_methods(&o, "realtime,realtime-with-pid,high-priority,high-priority-with-pid");
+
+        while ((c = getopt_long(argc, argv, "p:t:c:r:m:h", long_options, NULL)) >= 0) {
+                switch (c) {
+                case 'p':
+                        o.processes = (unsigned) strtoul(optarg, NULL, 0);
+                        break;
+                case 't':
+                        o.threads = (unsigned) strtoul(optarg, NULL, 0);
+                        break;
+                case 'c':
+                        o.calls = (unsigned) strtoul(optarg, NULL, 0);
+                        break;
+                case 'r':
+                        o.rate = strtod(optarg, NULL);
+                        break;
+                case 'm':
+                        if (parse_methods(&o, optarg) < 0) {
+                                fprintf(stderr, "Invalid method list: %s\n", optarg);
+                                return 1;
+                        }
+                        break;
+                case ARG_PRIORITY:
+                        o.priority = atoi(optarg);
+                        break;
+                case ARG_NICE:
+                        o.nice_level = atoi(optarg);
+                        break;
+                case 'h':
+                        load_usage(argv[0]);
+                        return 0;
+                default:
+                        return 1;
+                }
+        }
+
+        if (o.processes == 0 || o.threads == 0) {
+                fprintf(stderr, "Need at least one process and thread.\n");
+                return 1;
+        }
+
+        /* all processes share one monotonic clock, so they can agree on
+         * when to start */
+        start_usec = now_usec() + START_DELAY_USEC;
+        memset(&total, 0, sizeof(total));
+
+        fds = calloc(o.processes, sizeof(int));
+        pids = calloc(o.processes, sizeof(pid_t));
+        if (!fds || !pids) {
+                fprintf(stderr, "Out of memory\n");
+                free(fds);
+                free(pids);
+                return 1;
+        }
+
+        for (i = 0; i < o.processes; i++) {
+                int p[2];
+
+                if (pipe(p) < 0) {
+                        fprintf(stderr, "pipe() failed: %s\n", strerror(errno));
+                        ret = 1;
+                        break;
+                }
+
+                if ((pids[i] = fork()) < 0) {
+                        fprintf(stderr, "fork() failed: %s\n", strerror(errno));
+                        close(p[0]);
+                        close(p[1]);
+                        ret = 1;
+                        break;
+                }
+
+                if (pids[i] == 0) {
+                        close(p[0]);
+                        _exit(run_process(&o, i, start_usec, p[1]));
+                }
+
+                close(p[1]);
+                fds[i] = p[0];
+                started++;
+        }
+
+        for (i = 0; i < started; i++) {
+                struct stats s;
+                int status;
+
+                if (read(fds[i], &s, sizeof(s)) == (ssize_t) sizeof(s))
+                        merge(&total, &s);
+                else
+                        ret = 1;
+
+                close(fds[i]);
+
+                if (waitpid(pids[i], &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+                        ret = 1;
+        }
+
+        free(fds);
+        free(pids);
+
+        elapsed_usec = now_usec() - start_usec;
+
+        printf("%u processes, %u threads each, %u calls per thread in %llu ms\n",
+               started, o.threads, o.calls, elapsed_usec / 1000);
+        print_stats(&total);
+
+        return ret;
+}
@@ -0,0 +1,24 @@
+/*-*- Mode: C; c-basic-offset: 8 -*-*/
+
+#ifndef fooloadhfoo
+#define fooloadhfoo
+
+/***
+        Copyright (c) 2026 FreeBSD Foundation
+        SPDX-License-Identifier: BSD-3-Clause
+***/
+
+/* Load generator for the RealtimeKit1 interface: forks a number of
+ * processes, each running a number of threads that all start at the
+ * same moment and then issue priority requests at a fixed rate, like
+ * an audio server and its clients do on session startup. Prints a
+ * latency histogram per method and how many calls were rejected by
+ * the rate limiter.
+ *
+ * argv holds only the load options, see load_usage(). Returns the
+ * process exit code. */
+int run_load(int argc, char *argv[]);
+
+void load_usage(const char *name);
+
+#endif
@@ -26,6 +26,7 @@
 #include <sys/time.h>
 #include <sys/resource.h>
 
+#include "load.h"
 #include "rtkit.h"
 
 #ifndef SCHED_RESET_ON_FORK
@@ -80,6 +81,9 @@ int main(int argc, char *argv[]) {
         long long rttime_usec_max;
         struct rlimit rlim;
 
+        if (argc > 1)
+                return run_load(argc, argv);
+
         dbus_error_init(&error);
 
         if (!(bus = dbus_bus_get(DBUS_BUS_SYSTEM, &error))) {
@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2026 FreeBSD Foundation
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <memory>
+
+#include <QDBusConnection>
+#include <QDBusContext>
+#include <QDBusMessage>
+#include <QDBusServer>
+#include <QSet>
+#include <QTest>
+#include <QTimer>
+
+#include "CredentialsCache.h"
+
+// Lookups go to a peer that stands in for the bus daemon, so that the reply
+// for one caller can be held back while the others are answered
+
+static const QString DBusObjectPath = QStringLiteral("/org/freedesktop/DBus");
+
+class StubBus : public QObject,
+                protected QDBusContext
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.freedesktop.DBus")
+
+public:
+    void Hold(const QString& name) { m_held.insert(name); }
+
+    void Release()
+    {
+        m_held.clear();
+        for (const auto& call : std::as_const(m_heldCalls))
+            m_connection.send(call.createReply(QVariant::fromValue(credentialsOf(call.arguments().value(0).toString()))));
+        m_heldCalls.clear();
+    }
+
+    int Calls(const QString& name) const { return m_calls.value(name); }
+
+public Q_SLOTS:
+    QVariantMap GetConnectionCredentials(const QString& name)
+    {
+        m_calls[name]++;
+
+        if (name.endsWith(QLatin1String(".404"))) {
+            sendErrorReply(QDBusError::NameHasNoOwner, name);
+            return {};
+        }
+
+        if (m_held.contains(name)) {
+            setDelayedReply(true);
+            m_connection = connection();
+            m_heldCalls << message();
+            return {};
+        }
+
+        return credentialsOf(name);
+    }
+
+private:
+    // ":1.42" runs as uid 1042 with pid 42
+    static QVariantMap credentialsOf(const QString& name)
+    {
+        const uint id = name.section(u'.', 1).toUInt();
+        return {
+            {QStringLiteral("UnixUserID"), 1000 + id},
+            {QStringLiteral("ProcessID"), id},
+        };
+    }
+
+    QDBusConnection m_connection{QString()};
+    QSet<QString> m_held;
+    QList<QDBusMessage> m_heldCalls;
+    QHash<QString, int> m_calls;
+};
+
+class CredentialsCacheTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanup();
+    void cleanupTestCase();
+    void heldLookupDoesNotBlockOthers();
+    void concurrentLookupsShareOneCall();
+    void errorsAreNotCached();
+
+private:
+    void lookup(const QString& name);
+
+    QDBusServer* m_server = nullptr;
+    StubBus m_bus;
+    bool m_registered = false;
+    QDBusConnection m_client{QString()};
+    QHash<QString, QList<Credentials>> m_results;
+};
+
+void CredentialsCacheTest::initTestCase()
+{
+    m_server = new QDBusServer(this);
+    QVERIFY(m_server->isConnected());
+    connect(m_server, &QDBusServer::newConnection, this, [this](const QDBusConnection& connection) {
+        m_registered = QDBusConnection(connection).registerObject(DBusObjectPath, &m_bus,
+                                                                  QDBusConnection::ExportAllSlots);
+    });
+
+    m_client = QDBusConnection::connectToPeer(m_server->address(), QStringLiteral("credentials-cache-test"));
+    QVERIFY(m_client.isConnected());
+    QTRY_VERIFY(m_registered);
+}
+
+void CredentialsCacheTest::cleanup()
+{
+    // don't leave callbacks pointing at a finished test
+    m_bus.Release();
+    QTest::qWait(0);
+    m_results.clear();
+}
+
+void CredentialsCacheTest::cleanupTestCase()
+{
+    QDBusConnection::disconnectFromPeer(m_client.name());
+}
+
+void CredentialsCacheTest::lookup(const QString& name)
+{
+    CredentialsCache::getInstance()->Lookup(m_client, name, [this, name](const Credentials& creds) {
+        m_results[name] << creds;
+    });
+}
+
+void CredentialsCacheTest::heldLookupDoesNotBlockOthers()
+{
+    const QString slow = QStringLiteral(":1.1");
+    const QString fast = QStringLiteral(":1.2");
+    m_bus.Hold(slow);
+
+    // the event loop has to keep turning while the lookup is held
+    auto ticked = std::make_shared<bool>(false);
+    QTimer::singleShot(0, this, [ticked] { *ticked = true; });
+
+    lookup(slow);
+    QVERIFY(m_results.isEmpty());
+    lookup(fast);
+
+    QTRY_COMPARE(m_results.value(fast).size(), 1);
+    QVERIFY(*ticked);
+    QCOMPARE(m_bus.Calls(slow), 1);
+    QVERIFY(!m_results.contains(slow));
+
+    const auto& creds = m_results[fast].first();
+    QVERIFY(creds.isValid());
+    QCOMPARE(creds.uid, uid_t(1002));
+    QCOMPARE(creds.pid, pid_t(2));
+
+    m_bus.Release();
+    QTRY_COMPARE(m_results.value(slow).size(), 1);
+    QCOMPARE(m_results[slow].first().uid, uid_t(1001));
+}
+
+void CredentialsCacheTest::concurrentLookupsShareOneCall()
+{
+    const QString name = QStringLiteral(":1.3");
+    m_bus.Hold(name);
+
+    lookup(name);
+    lookup(name);
+    QTRY_COMPARE(m_bus.Calls(name), 1);
+    QVERIFY(m_results.isEmpty());
+
+    m_bus.Release();
+    QTRY_COMPARE(m_results.value(name).size(), 2);
+    for (const auto& creds : std::as_const(m_results[name])) {
+        QVERIFY(creds.isValid());
+        QCOMPARE(creds.pid, pid_t(3));
+    }
+    QCOMPARE(m_bus.Calls(name), 1);
+}
+
+void CredentialsCacheTest::errorsAreNotCached()
+{
+    const QString name = QStringLiteral(":1.404");
+
+    lookup(name);
+    QTRY_COMPARE(m_results.value(name).size(), 1);
+    QVERIFY(!m_results[name].first().isValid());
+    QCOMPARE(m_results[name].first().error().type(), QDBusError::NameHasNoOwner);
+
+    lookup(name);
+    QTRY_COMPARE(m_results.value(name).size(), 2);
+    QCOMPARE(m_bus.Calls(name), 2);
+}
+
+QTEST_GUILESS_MAIN(CredentialsCacheTest)
+
+#include "CredentialsCacheTest.moc"
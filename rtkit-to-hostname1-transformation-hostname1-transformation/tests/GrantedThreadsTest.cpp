@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2026 FreeBSD Foundation
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <unistd.h>
+
+#include <QTest>
+
+#include "GrantedThreads.h"
+
+namespace
+{
+
+// Lets two processes share a pid, as when the first one exited unnoticed
+struct FakeProcess : Process
+{
+    FakeProcess(pid_t pid, qulonglong startTime)
+        : Process(pid, getuid(), startTime)
+    {}
+};
+
+std::shared_ptr<Process> MakeProcess(pid_t pid, qulonglong startTime)
+{
+    return std::make_shared<FakeProcess>(pid, startTime);
+}
+
+}
+
+class GrantedThreadsTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void insert();
+    void reusedPid();
+    void removePid();
+};
+
+void GrantedThreadsTest::insert()
+{
+    GrantedThreads granted;
+    auto process = MakeProcess(100, 1);
+
+    granted.Insert(process, 101, PriorityType::Realtime, 10);
+    granted.Insert(process, 101, PriorityType::High, -5);
+    granted.Insert(process, 102, PriorityType::Idle, 0);
+
+    QCOMPARE(granted.ProcessCount(), qsizetype(1));
+    QVERIFY(granted.Contains(*process));
+    QVERIFY(granted.FindPid(100) == process.get());
+    QVERIFY(!granted.FindPid(200));
+
+    const auto entries = granted.TakeAll();
+    QCOMPARE(entries.size(), qsizetype(1));
+    QCOMPARE(entries[0].threads.size(), qsizetype(2));
+    QVERIFY(entries[0].threads[101].type == PriorityType::High);
+    QCOMPARE(entries[0].threads[101].value, qlonglong(-5));
+    QCOMPARE(granted.ProcessCount(), qsizetype(0));
+}
+
+void GrantedThreadsTest::reusedPid()
+{
+    GrantedThreads granted;
+    // enough neighbours that the stale entry is not alone in its span
+    QList<std::shared_ptr<Process>> others;
+    for (pid_t pid = 1000; pid < 1200; pid++) {
+        others << MakeProcess(pid, 1);
+        granted.Insert(others.last(), pid, PriorityType::Realtime, 1);
+    }
+
+    auto stale = MakeProcess(100, 1);
+    auto current = MakeProcess(100, 2);
+    granted.Insert(stale, 101, PriorityType::Realtime, 10);
+    granted.Insert(current, 102, PriorityType::High, -5);
+
+    QVERIFY(granted.FindPid(100) == current.get());
+    QVERIFY(!granted.Contains(*stale));
+    QVERIFY(granted.Contains(*current));
+    QCOMPARE(granted.ProcessCount(), others.size() + 1);
+
+    for (const auto& entry : granted.TakeAll()) {
+        if (entry.process != current) {
+            QCOMPARE(entry.threads.size(), qsizetype(1));
+            QVERIFY(entry.threads.contains(entry.process->Pid()));
+            continue;
+        }
+        QCOMPARE(entry.threads.size(), qsizetype(1));
+        QVERIFY(entry.threads[102].type == PriorityType::High);
+    }
+}
+
+void GrantedThreadsTest::removePid()
+{
+    GrantedThreads granted;
+    auto process = MakeProcess(100, 1);
+    granted.Insert(process, 101, PriorityType::Realtime, 10);
+
+    granted.RemovePid(100);
+    QVERIFY(!granted.FindPid(100));
+    QVERIFY(!granted.Contains(*process));
+    QCOMPARE(granted.ProcessCount(), qsizetype(0));
+
+    // unknown pids are ignored
+    granted.RemovePid(100);
+}
+
+QTEST_APPLESS_MAIN(GrantedThreadsTest)
+
+#include "GrantedThreadsTest.moc"
@@ -0,0 +1,257 @@
+/*
+ * Copyright (c) 2026 FreeBSD Foundation
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <QFile>
+#include <QTest>
+
+#include "SMBIOS.h"
+
+// Runs the decoder over dumps laid out like /sys/firmware/dmi/tables, one
+// directory per machine with its smbios_entry_point and DMI files. They are
+// synthetic, see data/smbios/generate.py.
+
+static const QString DataDir = QStringLiteral(SMBIOS_DATA_DIR);
+
+namespace
+{
+
+QByteArray ReadDump(const QString& machine, const QString& name)
+{
+    QFile file(DataDir + u'/' + machine + u'/' + name);
+    if (!file.open(QIODevice::ReadOnly))
+        qFatal("Cannot open %s", qPrintable(file.fileName()));
+    return file.readAll();
+}
+
+// offset of the first structure after the BIOS one, whose strings end with
+// the release date
+qsizetype SystemOffset(const QByteArray& table, const char* firmwareDate)
+{
+    return table.indexOf(firmwareDate) + qstrlen(firmwareDate) + 2;
+}
+
+}
+
+class SMBIOSTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void entryPoint_data();
+    void entryPoint();
+    void invalidEntryPoint_data();
+    void invalidEntryPoint();
+    void table_data();
+    void table();
+    void uuidByteOrder();
+    void truncatedTable();
+    void tableLengthBounds();
+    void structureOutOfBounds();
+};
+
+void SMBIOSTest::entryPoint_data()
+{
+    QTest::addColumn<QString>("machine");
+    QTest::addColumn<int>("major");
+    QTest::addColumn<int>("minor");
+    QTest::addColumn<quint32>("tableLength");
+    QTest::addColumn<quint64>("tableAddress");
+
+    QTest::newRow("_SM3_") << "synthetic-sm3-3.0" << 3 << 0 << quint32(0x1A9) << quint64(0x7F8E6000);
+    QTest::newRow("_SM_") << "synthetic-sm-2.8" << 2 << 8 << quint32(0xA8) << quint64(0xF0A40);
+    QTest::newRow("_DMI_") << "synthetic-dmi-2.3" << 2 << 3 << quint32(0x9F) << quint64(0xF0800);
+}
+
+void SMBIOSTest::entryPoint()
+{
+    QFETCH(QString, machine);
+
+    const SMBIOS::EntryPoint entryPoint = SMBIOS::ParseEntryPoint(ReadDump(machine, QStringLiteral("smbios_entry_point")));
+    QVERIFY(entryPoint.isValid());
+    QTEST(entryPoint.major, "major");
+    QTEST(entryPoint.minor, "minor");
+    QTEST(entryPoint.tableLength, "tableLength");
+    QTEST(entryPoint.tableAddress, "tableAddress");
+}
+
+void SMBIOSTest::invalidEntryPoint_data()
+{
+    QTest::addColumn<QByteArray>("data");
+
+    const QByteArray sm3 = ReadDump(QStringLiteral("synthetic-sm3-3.0"), QStringLiteral("smbios_entry_point"));
+    const QByteArray sm = ReadDump(QStringLiteral("synthetic-sm-2.8"), QStringLiteral("smbios_entry_point"));
+    const QByteArray dmi = ReadDump(QStringLiteral("synthetic-dmi-2.3"), QStringLiteral("smbios_entry_point"));
+
+    auto corrupt = [](QByteArray data, qsizetype offset) {
+        data[offset] = char(data[offset] + 1);
+        return data;
+    };
+
+    QTest::newRow("_SM3_ checksum") << corrupt(sm3, 0x0C);
+    QTest::newRow("_SM_ checksum") << corrupt(sm, 0x16);
+    QTest::newRow("_DMI_ checksum") << corrupt(dmi, 0x06);
+    QTest::newRow("_SM3_ truncated") << sm3.first(sm3.size() - 1);
+    QTest::newRow("_SM_ truncated") << sm.first(sm.size() - 1);
+    QTest::newRow("_DMI_ truncated") << dmi.first(dmi.size() - 1);
+    // checksummed length past the end of the buffer
+    QTest::newRow("_SM3_ length") << corrupt(sm3, 0x06);
+    QTest::newRow("unknown anchor") << QByteArray("_XYZ_").append(sm3.sliced(5));
+    QTest::newRow("empty") << QByteArray();
+}
+
+void SMBIOSTest::invalidEntryPoint()
+{
+    QFETCH(QByteArray, data);
+
+    QVERIFY(!SMBIOS::ParseEntryPoint(data).isValid());
+}
+
+void SMBIOSTest::table_data()
+{
+    QTest::addColumn<QString>("machine");
+    QTest::addColumn<QString>("vendor");
+    QTest::addColumn<QString>("model");
+    QTest::addColumn<QString>("serial");
+    QTest::addColumn<QString>("firmwareVendor");
+    QTest::addColumn<QString>("firmwareVersion");
+    QTest::addColumn<QString>("firmwareDate");
+    QTest::addColumn<QByteArray>("productUUID");
+    QTest::addColumn<QString>("chassis");
+
+    QTest::newRow("_SM3_")
+        << "synthetic-sm3-3.0" << "Example Corp" << "Example Tablet T3" << "T3-0001"
+        << "Example Firmware" << "3.0.1" << "02/06/2015"
+        << QByteArray::fromHex("a3e1c7d20b5f4e6a8c9d112233445566") << "tablet";
+    QTest::newRow("_SM_")
+        << "synthetic-sm-2.8" << "Example Corp" << "Example Desktop D2" << "D2-0001"
+        << "Example Firmware" << "2.8.4" << "04/01/2014"
+        << QByteArray::fromHex("5f1c3b6a8d2e4f479a610c3e2b7d9a10") << "";
+    QTest::newRow("_DMI_")
+        << "synthetic-dmi-2.3" << "Example Corp" << "Example Laptop L1" << "L1-0001"
+        << "Example Firmware" << "F4" << "07/23/2003"
+        << QByteArray::fromHex("00112233445566778899aabbccddeeff") << "laptop";
+}
+
+void SMBIOSTest::table()
+{
+    QFETCH(QString, machine);
+
+    const SMBIOS::EntryPoint entryPoint = SMBIOS::ParseEntryPoint(ReadDump(machine, QStringLiteral("smbios_entry_point")));
+    QVERIFY(entryPoint.isValid());
+
+    SystemInfo::Hardware hw;
+    QVERIFY(SMBIOS::ParseTable(entryPoint, ReadDump(machine, QStringLiteral("DMI")), hw));
+    QTEST(hw.vendor, "vendor");
+    QTEST(hw.model, "model");
+    QTEST(hw.serial, "serial");
+    QTEST(hw.firmwareVendor, "firmwareVendor");
+    QTEST(hw.firmwareVersion, "firmwareVersion");
+    QTEST(hw.firmwareDate, "firmwareDate");
+    QTEST(hw.productUUID, "productUUID");
+    QTEST(hw.chassis, "chassis");
+}
+
+void SMBIOSTest::uuidByteOrder()
+{
+    const QString machine = QStringLiteral("synthetic-sm-2.8");
+    const QByteArray table = ReadDump(machine, QStringLiteral("DMI"));
+    SMBIOS::EntryPoint entryPoint = SMBIOS::ParseEntryPoint(ReadDump(machine, QStringLiteral("smbios_entry_point")));
+
+    // the same bytes read as wire order before 2.6
+    entryPoint.minor = 5;
+    SystemInfo::Hardware hw;
+    QVERIFY(SMBIOS::ParseTable(entryPoint, table, hw));
+    QCOMPARE(hw.productUUID, QByteArray::fromHex("6a3b1c5f2e8d474f9a610c3e2b7d9a10"));
+
+    // all ones means not set
+    QByteArray unset = table;
+    const qsizetype system = SystemOffset(table, "04/01/2014");
+    unset.replace(system + 0x08, 16, QByteArray(16, '\xff'));
+    hw = {};
+    QVERIFY(SMBIOS::ParseTable(entryPoint, unset, hw));
+    QVERIFY(hw.productUUID.isEmpty());
+}
+
+void SMBIOSTest::truncatedTable()
+{
+    const QString machine = QStringLiteral("synthetic-sm-2.8");
+    const QByteArray table = ReadDump(machine, QStringLiteral("DMI"));
+    const SMBIOS::EntryPoint entryPoint = SMBIOS::ParseEntryPoint(ReadDump(machine, QStringLiteral("smbios_entry_point")));
+
+    // the System structure ends with its serial and the string set terminator
+    const qsizetype systemEnd = table.indexOf("D2-0001") + qstrlen("D2-0001") + 2;
+
+    for (qsizetype size = 0; size <= table.size(); size++) {
+        SystemInfo::Hardware hw;
+        const bool ok = SMBIOS::ParseTable(entryPoint, table.first(size), hw);
+        QCOMPARE(ok, size >= systemEnd);
+        if (ok) {
+            QCOMPARE(hw.vendor, QStringLiteral("Example Corp"));
+            QCOMPARE(hw.serial, QStringLiteral("D2-0001"));
+        }
+    }
+
+    // cut inside the System strings: the BIOS structure is still decoded
+    SystemInfo::Hardware hw;
+    QVERIFY(!SMBIOS::ParseTable(entryPoint, table.first(systemEnd - 4), hw));
+    QCOMPARE(hw.firmwareVendor, QStringLiteral("Example Firmware"));
+    QVERIFY(hw.vendor.isEmpty());
+}
+
+void SMBIOSTest::tableLengthBounds()
+{
+    const QString machine = QStringLiteral("synthetic-sm-2.8");
+    const QByteArray table = ReadDump(machine, QStringLiteral("DMI"));
+    SMBIOS::EntryPoint entryPoint = SMBIOS::ParseEntryPoint(ReadDump(machine, QStringLiteral("smbios_entry_point")));
+
+    // a table length covering only the BIOS structure hides the rest
+    entryPoint.tableLength = SystemOffset(table, "04/01/2014");
+    SystemInfo::Hardware hw;
+    QVERIFY(!SMBIOS::ParseTable(entryPoint, table, hw));
+    QCOMPARE(hw.firmwareVersion, QStringLiteral("2.8.4"));
+    QVERIFY(hw.vendor.isEmpty());
+
+    // one that is larger than the buffer is clamped to it
+    entryPoint.tableLength = 0xFFFF;
+    hw = {};
+    QVERIFY(SMBIOS::ParseTable(entryPoint, table, hw));
+    QCOMPARE(hw.model, QStringLiteral("Example Desktop D2"));
+}
+
+void SMBIOSTest::structureOutOfBounds()
+{
+    const QString machine = QStringLiteral("synthetic-sm-2.8");
+    const QByteArray table = ReadDump(machine, QStringLiteral("DMI"));
+    const SMBIOS::EntryPoint entryPoint = SMBIOS::ParseEntryPoint(ReadDump(machine, QStringLiteral("smbios_entry_point")));
+    const qsizetype system = SystemOffset(table, "04/01/2014");
+    QCOMPARE(quint8(table[system]), quint8(1));
+
+    // formatted area running past the end of the table
+    QByteArray corrupt = table;
+    corrupt[system + 1] = char(0xFF);
+    SystemInfo::Hardware hw;
+    QVERIFY(!SMBIOS::ParseTable(entryPoint, corrupt, hw));
+    QCOMPARE(hw.firmwareVendor, QStringLiteral("Example Firmware"));
+    QVERIFY(hw.vendor.isEmpty());
+
+    // formatted area shorter than the header
+    corrupt = table;
+    corrupt[system + 1] = char(2);
+    hw = {};
+    QVERIFY(!SMBIOS::ParseTable(entryPoint, corrupt, hw));
+    QVERIFY(hw.vendor.isEmpty());
+
+    // too short for the UUID, the rest of the structure then reads as
+    // strings and must not take the walk out of the table
+    corrupt = table;
+    corrupt[system + 1] = char(0x08);
+    hw = {};
+    SMBIOS::ParseTable(entryPoint, corrupt, hw);
+    QVERIFY(hw.productUUID.isEmpty());
+}
+
+QTEST_APPLESS_MAIN(SMBIOSTest)
+
+#include "SMBIOSTest.moc"
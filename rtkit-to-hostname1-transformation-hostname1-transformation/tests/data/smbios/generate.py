@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2026 FreeBSD Foundation
+# SPDX-License-Identifier: BSD-3-Clause
+#
+# Writes the synthetic SMBIOS dumps used by SMBIOSTest, one directory per
+# entry point flavour, laid out like /sys/firmware/dmi/tables. Strings and
+# identifiers are made up; structure lengths follow the specification
+# version each dump claims. Run from this directory after editing.
+
+import os
+import struct
+import uuid
+
+
+def strings(*values):
+    values = [value for value in values if value]
+    if not values:
+        return b'\0\0'
+    return b''.join(value.encode() + b'\0' for value in values) + b'\0'
+
+
+def checksum(buf, at, start, end):
+    buf[at] = 0
+    buf[at] = -sum(buf[start:end]) & 0xFF
+
+
+# 7.1 BIOS Information (Type 0), formatted area cut to the version's length
+def bios(handle, length, vendor, version, date):
+    formatted = struct.pack('<BBHBBHBBQHBBBB', 0, length, handle, 1, 2, 0xE800, 3, 0,
+                            0x08, 0, 0, 0, 0xFF, 0xFF)
+    return formatted[:length].ljust(length, b'\0') + strings(vendor, version, date)
+
+
+# 7.2 System Information (Type 1), 2.4+ layout; from 2.6 on the first three
+# UUID fields are stored little endian
+def system(handle, vendor, model, serial, product_uuid, mixed_endian):
+    raw = uuid.UUID(product_uuid)
+    formatted = struct.pack('<BBHBBBB', 1, 0x1B, handle, 1, 2, 0, 3)
+    formatted += raw.bytes_le if mixed_endian else raw.bytes
+    formatted += struct.pack('<BBB', 6, 0, 0)
+    return formatted + strings(vendor, model, serial)
+
+
+# 7.4 System Enclosure or Chassis (Type 3)
+def chassis(handle, vendor, chassis_type):
+    formatted = struct.pack('<BBHBBBBBBBBIBB', 3, 0x15, handle, 1, chassis_type, 0, 0, 0,
+                            3, 3, 3, 0, 0, 0)
+    return formatted.ljust(0x15, b'\0') + strings(vendor)
+
+
+# 7.45 End-of-Table (Type 127)
+def end(handle):
+    return struct.pack('<BBH', 127, 4, handle) + strings()
+
+
+def sm3(table, address):
+    entry = bytearray(0x18)
+    entry[0:5] = b'_SM3_'
+    entry[0x06] = 0x18
+    entry[0x07:0x0B] = bytes([3, 0, 0, 1])
+    # only an upper bound of the table size
+    struct.pack_into('<IQ', entry, 0x0C, len(table) + 0x100, address)
+    checksum(entry, 0x05, 0, 0x18)
+    return entry
+
+
+def sm(table, address, major, minor):
+    entry = bytearray(0x1F)
+    entry[0:4] = b'_SM_'
+    entry[0x05:0x08] = bytes([0x1F, major, minor])
+    struct.pack_into('<H', entry, 0x08, 0x44)
+    entry[0x10:0x15] = b'_DMI_'
+    struct.pack_into('<HIHB', entry, 0x16, len(table), address, 4, major << 4 | minor)
+    checksum(entry, 0x15, 0x10, 0x1F)
+    checksum(entry, 0x04, 0, 0x1F)
+    return entry
+
+
+def dmi(table, address, major, minor):
+    entry = bytearray(0x0F)
+    entry[0:5] = b'_DMI_'
+    struct.pack_into('<HIHB', entry, 0x06, len(table), address, 4, major << 4 | minor)
+    checksum(entry, 0x05, 0, 0x0F)
+    return entry
+
+
+def write(name, entry, table):
+    os.makedirs(name, exist_ok=True)
+    with open(os.path.join(name, 'smbios_entry_point'), 'wb') as f:
+        f.write(entry)
+    with open(os.path.join(name, 'DMI'), 'wb') as f:
+        f.write(table)
+
+
+table = (bios(0, 0x1A, 'Example Firmware', '3.0.1', '02/06/2015')
+         + system(0x100, 'Example Corp', 'Example Tablet T3', 'T3-0001',
+                  'a3e1c7d2-0b5f-4e6a-8c9d-112233445566', True)
+         + chassis(0x300, 'Example Corp', 0x1E)
+         + end(0x7F00))
+write('synthetic-sm3-3.0', sm3(table, 0x7F8E6000), table)
+
+table = (bios(0, 0x18, 'Example Firmware', '2.8.4', '04/01/2014')
+         + system(0x100, 'Example Corp', 'Example Desktop D2', 'D2-0001',
+                  '5f1c3b6a-8d2e-4f47-9a61-0c3e2b7d9a10', True)
+         + chassis(0x300, 'Example Corp', 0x01)
+         + end(0x7F00))
+write('synthetic-sm-2.8', sm(table, 0x000F0A40, 2, 8), table)
+
+# bit 7 of the chassis type is the lock
+table = (bios(0, 0x13, 'Example Firmware', 'F4', '07/23/2003')
+         + system(1, 'Example Corp', 'Example Laptop L1', 'L1-0001',
+                  '00112233-4455-6677-8899-aabbccddeeff', False)
+         + chassis(2, 'Example Corp', 0x89)
+         + end(3))
+write('synthetic-dmi-2.3', dmi(table, 0x000F0800, 2, 3), table)